@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "rangesizeset.h"
+
+namespace HyoutaUtilities {
+// Like RangeSizeSet, but all ranges must lie within a single arena that starts at a base value given on construction.
+// Internally only the offsets relative to that base are stored, so eg. a set of void* ranges within a 4 GiB arena can
+// use 32-bit keys instead of 64-bit ones, which halves the size of each key in both the range map and the by-size map.
+// The public interface still deals in T. Since the stored values don't exist as T, the iterators return their 'from'
+// and 'to' by value instead of by reference.
+template <typename T, typename OffsetT = uint32_t> class BasedRangeSizeSet {
+  static_assert(std::is_unsigned_v<OffsetT>, "Offsets must be unsigned.");
+
+private:
+  using InnerT = RangeSizeSet<OffsetT>;
+
+public:
+  using SizeT = typename InnerT::SizeT;
+
+  struct by_size_const_iterator;
+
+  struct const_iterator {
+  public:
+    T from() const {
+      return to_value(Base, It.from());
+    }
+
+    T to() const {
+      return to_value(Base, It.to());
+    }
+
+    const_iterator& operator++() {
+      ++It;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++It;
+      return old;
+    }
+
+    const_iterator& operator--() {
+      --It;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      --It;
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->It == rhs.It;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+    by_size_const_iterator to_size_iterator() {
+      return by_size_const_iterator(Base, It.to_size_iterator());
+    }
+
+  private:
+    T Base;
+    typename InnerT::const_iterator It;
+    const_iterator(T base, typename InnerT::const_iterator it) : Base(base), It(it) {}
+    friend class BasedRangeSizeSet;
+  };
+
+  struct by_size_const_iterator {
+  public:
+    T from() const {
+      return to_value(Base, It.from());
+    }
+
+    T to() const {
+      return to_value(Base, It.to());
+    }
+
+    by_size_const_iterator& operator++() {
+      ++It;
+      return *this;
+    }
+
+    by_size_const_iterator operator++(int) {
+      by_size_const_iterator old = *this;
+      ++It;
+      return old;
+    }
+
+    by_size_const_iterator& operator--() {
+      --It;
+      return *this;
+    }
+
+    by_size_const_iterator operator--(int) {
+      by_size_const_iterator old = *this;
+      --It;
+      return old;
+    }
+
+    bool operator==(const by_size_const_iterator& rhs) const {
+      return this->It == rhs.It;
+    }
+
+    bool operator!=(const by_size_const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+    const_iterator to_range_iterator() {
+      return const_iterator(Base, It.to_range_iterator());
+    }
+
+  private:
+    T Base;
+    typename InnerT::by_size_const_iterator It;
+    by_size_const_iterator(T base, typename InnerT::by_size_const_iterator it) : Base(base), It(it) {}
+    friend class BasedRangeSizeSet;
+  };
+
+  // All values passed to this set must be in [base, base + max value of OffsetT].
+  explicit BasedRangeSizeSet(T base) : Base(base) {}
+
+  // Like RangeSizeSet, this can't be copied.
+  BasedRangeSizeSet(const BasedRangeSizeSet<T, OffsetT>&) = delete;
+  BasedRangeSizeSet(BasedRangeSizeSet<T, OffsetT>&&) = default;
+  BasedRangeSizeSet<T, OffsetT>& operator=(const BasedRangeSizeSet<T, OffsetT>&) = delete;
+  BasedRangeSizeSet<T, OffsetT>& operator=(BasedRangeSizeSet<T, OffsetT>&&) = default;
+
+  T base() const {
+    return Base;
+  }
+
+  void insert(T from, T to) {
+    if (from >= to)
+      return;
+    Inner.insert(to_offset(from), to_offset(to));
+  }
+
+  void erase(T from, T to) {
+    if (from >= to)
+      return;
+    Inner.erase(to_offset(from), to_offset(to));
+  }
+
+  const_iterator erase(const_iterator it) {
+    return const_iterator(Base, Inner.erase(it.It));
+  }
+
+  by_size_const_iterator erase(by_size_const_iterator it) {
+    return by_size_const_iterator(Base, Inner.erase(it.It));
+  }
+
+  void clear() {
+    Inner.clear();
+  }
+
+  bool contains(T value) const {
+    if (value < Base || calc_offset(value) > std::numeric_limits<OffsetT>::max())
+      return false;
+    return Inner.contains(static_cast<OffsetT>(calc_offset(value)));
+  }
+
+  std::size_t size() const {
+    return Inner.size();
+  }
+
+  bool empty() const {
+    return Inner.empty();
+  }
+
+  std::size_t by_size_count(const SizeT& key) const {
+    return Inner.by_size_count(key);
+  }
+
+  by_size_const_iterator by_size_find(const SizeT& key) const {
+    return by_size_const_iterator(Base, Inner.by_size_find(key));
+  }
+
+  std::pair<by_size_const_iterator, by_size_const_iterator> by_size_equal_range(const SizeT& key) const {
+    auto p = Inner.by_size_equal_range(key);
+    return std::pair<by_size_const_iterator, by_size_const_iterator>(by_size_const_iterator(Base, p.first),
+                                                                     by_size_const_iterator(Base, p.second));
+  }
+
+  by_size_const_iterator by_size_lower_bound(const SizeT& key) const {
+    return by_size_const_iterator(Base, Inner.by_size_lower_bound(key));
+  }
+
+  by_size_const_iterator by_size_upper_bound(const SizeT& key) const {
+    return by_size_const_iterator(Base, Inner.by_size_upper_bound(key));
+  }
+
+  by_size_const_iterator by_size_best_fit(const SizeT& size) const {
+    return by_size_const_iterator(Base, Inner.by_size_best_fit(size));
+  }
+
+  void swap(BasedRangeSizeSet<T, OffsetT>& other) {
+    std::swap(Base, other.Base);
+    Inner.swap(other.Inner);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(Base, Inner.begin());
+  }
+
+  const_iterator end() const {
+    return const_iterator(Base, Inner.end());
+  }
+
+  const_iterator cbegin() const {
+    return const_iterator(Base, Inner.cbegin());
+  }
+
+  const_iterator cend() const {
+    return const_iterator(Base, Inner.cend());
+  }
+
+  by_size_const_iterator by_size_begin() const {
+    return by_size_const_iterator(Base, Inner.by_size_begin());
+  }
+
+  by_size_const_iterator by_size_end() const {
+    return by_size_const_iterator(Base, Inner.by_size_end());
+  }
+
+  by_size_const_iterator by_size_cbegin() const {
+    return by_size_const_iterator(Base, Inner.by_size_cbegin());
+  }
+
+  by_size_const_iterator by_size_cend() const {
+    return by_size_const_iterator(Base, Inner.by_size_cend());
+  }
+
+  // Two sets are equal if they contain the same ranges, even if their bases differ.
+  bool operator==(const BasedRangeSizeSet<T, OffsetT>& other) const {
+    if (this->Base == other.Base)
+      return this->Inner == other.Inner;
+    if (this->size() != other.size())
+      return false;
+    for (auto a = this->begin(), b = other.begin(); a != this->end(); ++a, ++b) {
+      if (a.from() != b.from() || a.to() != b.to())
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const BasedRangeSizeSet<T, OffsetT>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    return Inner.get_stats();
+  }
+
+private:
+  // Distance of the given value from the base, in the same units that RangeSizeSet uses for sizes.
+  std::uintmax_t calc_offset(T value) const {
+    if constexpr (std::is_pointer_v<T>) {
+      // For pointers we don't want pointer arithmetic here, else void* breaks.
+      return reinterpret_cast<std::uintptr_t>(value) - reinterpret_cast<std::uintptr_t>(Base);
+    } else {
+      return static_cast<std::uintmax_t>(value - Base);
+    }
+  }
+
+  OffsetT to_offset(T value) const {
+    assert(Base <= value);
+    assert(calc_offset(value) <= std::numeric_limits<OffsetT>::max());
+    return static_cast<OffsetT>(calc_offset(value));
+  }
+
+  static T to_value(T base, OffsetT offset) {
+    if constexpr (std::is_pointer_v<T>) {
+      return reinterpret_cast<T>(reinterpret_cast<std::uintptr_t>(base) + offset);
+    } else {
+      return static_cast<T>(base + offset);
+    }
+  }
+
+  T Base;
+  InnerT Inner;
+};
+} // namespace HyoutaUtilities
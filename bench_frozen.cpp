@@ -0,0 +1,69 @@
+// Compares lookups in a FrozenRangeSet against RangeSet and a binary search over a plain sorted array.
+// Usage: bench_frozen [largest range count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "frozenrangeset.h"
+#include "rangeset.h"
+
+template <typename F> static double ns_per_query(const std::vector<uint64_t>& queries, std::size_t& hits, F&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  std::size_t found = 0;
+  for (uint64_t query : queries)
+    found += fn(query) ? 1 : 0;
+  const auto end = std::chrono::steady_clock::now();
+  hits = found;
+  return std::chrono::duration<double, std::nano>(end - start).count() / queries.size();
+}
+
+int main(int argc, char** argv) {
+  const std::size_t largest = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  constexpr std::size_t QueryCount = 2000000;
+
+  std::printf("%10s %12s %12s %12s\n", "ranges", "map ns", "array ns", "frozen ns");
+  for (std::size_t count = 100000; count <= largest; count *= 10) {
+    std::mt19937_64 rng(count);
+    std::uniform_int_distribution<uint64_t> gap(1, 64);
+    HyoutaUtilities::RangeSet<uint64_t> rs;
+    std::vector<std::pair<uint64_t, uint64_t>> sorted;
+    sorted.reserve(count);
+    uint64_t pos = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      pos += gap(rng);
+      const uint64_t to = pos + gap(rng);
+      rs.append(pos, to);
+      sorted.emplace_back(pos, to);
+      pos = to;
+    }
+    const auto fs = HyoutaUtilities::freeze(rs);
+
+    std::uniform_int_distribution<uint64_t> point(0, pos);
+    std::vector<uint64_t> queries(QueryCount);
+    for (auto& query : queries)
+      query = point(rng);
+
+    std::size_t map_hits;
+    std::size_t array_hits;
+    std::size_t frozen_hits;
+    const double map_ns = ns_per_query(queries, map_hits, [&](uint64_t value) { return rs.contains(value); });
+    const double array_ns = ns_per_query(queries, array_hits, [&](uint64_t value) {
+      auto it = std::upper_bound(sorted.begin(), sorted.end(), value,
+                                 [](uint64_t v, const std::pair<uint64_t, uint64_t>& r) { return v < r.first; });
+      return it != sorted.begin() && value < std::prev(it)->second;
+    });
+    const double frozen_ns = ns_per_query(queries, frozen_hits, [&](uint64_t value) { return fs.contains(value); });
+    if (map_hits != array_hits || map_hits != frozen_hits) {
+      std::printf("lookup results differ!\n");
+      return 1;
+    }
+    std::printf("%10zu %12.1f %12.1f %12.1f\n", count, map_ns, array_ns, frozen_ns);
+  }
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Compares lookups in a LearnedRangeSet against RangeSet, a binary search over a sorted array and FrozenRangeSet, on
+// range starts that are spread uniformly, clustered, or spaced adversarially for a linear model.
+// Usage: bench_learned [range count] [max error]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "frozenrangeset.h"
+#include "learnedrangeset.h"
+#include "rangeset.h"
+
+template <typename F> static double ns_per_query(const std::vector<uint64_t>& queries, std::size_t& hits, F&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  std::size_t found = 0;
+  for (uint64_t query : queries)
+    found += fn(query) ? 1 : 0;
+  const auto end = std::chrono::steady_clock::now();
+  hits = found;
+  return std::chrono::duration<double, std::nano>(end - start).count() / queries.size();
+}
+
+int main(int argc, char** argv) {
+  const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  const std::size_t max_error = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 32;
+  constexpr std::size_t QueryCount = 2000000;
+  const char* const names[] = {"uniform", "clustered", "adversarial"};
+
+  std::printf("%12s %10s %10s %10s %10s %10s\n", "distribution", "segments", "map ns", "array ns", "frozen ns",
+              "learned ns");
+  for (int kind = 0; kind < 3; ++kind) {
+    std::mt19937_64 rng(count + kind);
+    HyoutaUtilities::RangeSet<uint64_t> rs;
+    std::vector<std::pair<uint64_t, uint64_t>> sorted;
+    sorted.reserve(count);
+    uint64_t pos = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      uint64_t gap;
+      if (kind == 0) {
+        // Free blocks of similar size, evenly spread.
+        gap = 4096 + rng() % 4096;
+      } else if (kind == 1) {
+        // Dense clusters of small blocks far apart from each other.
+        gap = (i % 1000 == 0) ? (uint64_t(1) << 30) + rng() % 4096 : 16 + rng() % 64;
+      } else {
+        // Gaps of wildly different magnitudes, so a line never fits for long.
+        gap = uint64_t(1) << (rng() % 24);
+      }
+      pos += gap;
+      const uint64_t to = pos + 1 + rng() % 8;
+      rs.append(pos, to);
+      sorted.emplace_back(pos, to);
+      pos = to;
+    }
+    const auto fs = HyoutaUtilities::freeze(rs);
+    const auto ls = HyoutaUtilities::freeze_learned(rs, max_error);
+
+    std::uniform_int_distribution<uint64_t> point(0, pos);
+    std::vector<uint64_t> queries(QueryCount);
+    for (std::size_t i = 0; i < QueryCount; ++i) {
+      // Half of the lookups at a range start, so clustered sets don't only see lookups in the big gaps.
+      queries[i] = (i % 2) ? point(rng) : sorted[rng() % count].first;
+    }
+
+    std::size_t map_hits;
+    std::size_t array_hits;
+    std::size_t frozen_hits;
+    std::size_t learned_hits;
+    const double map_ns = ns_per_query(queries, map_hits, [&](uint64_t value) { return rs.contains(value); });
+    const double array_ns = ns_per_query(queries, array_hits, [&](uint64_t value) {
+      auto it = std::upper_bound(sorted.begin(), sorted.end(), value,
+                                 [](uint64_t v, const std::pair<uint64_t, uint64_t>& r) { return v < r.first; });
+      return it != sorted.begin() && value < std::prev(it)->second;
+    });
+    const double frozen_ns = ns_per_query(queries, frozen_hits, [&](uint64_t value) { return fs.contains(value); });
+    const double learned_ns = ns_per_query(queries, learned_hits, [&](uint64_t value) { return ls.contains(value); });
+    if (map_hits != array_hits || map_hits != frozen_hits || map_hits != learned_hits) {
+      std::printf("lookup results differ!\n");
+      return 1;
+    }
+    std::printf("%12s %10zu %10.1f %10.1f %10.1f %10.1f\n", names[kind], ls.segment_count(), map_ns, array_ns,
+                frozen_ns, learned_ns);
+  }
+  return 0;
+}
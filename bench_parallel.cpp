@@ -0,0 +1,74 @@
+// Measures how bulk building and set algebra scale with the number of threads.
+// Usage: bench_parallel [range count] [max thread count]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rangeset.h"
+#include "rangesetparallel.h"
+
+using Ranges = std::vector<std::pair<uint64_t, uint64_t>>;
+
+static Ranges random_ranges(uint32_t seed, std::size_t count) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<uint64_t> start(0, uint64_t(1) << 40);
+  std::uniform_int_distribution<uint64_t> length(1, 1 << 16);
+  Ranges ranges;
+  ranges.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const uint64_t from = start(rng);
+    ranges.emplace_back(from, from + length(rng));
+  }
+  return ranges;
+}
+
+template <typename F> static double time_ms(F&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+  const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  unsigned max_threads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                  : std::thread::hardware_concurrency();
+  if (max_threads == 0)
+    max_threads = 1;
+
+  const Ranges input = random_ranges(1, count);
+  const Ranges other_input = random_ranges(2, count);
+
+  const double serial_insert = time_ms([&] {
+    HyoutaUtilities::RangeSet<uint64_t> rs;
+    for (const auto& range : input)
+      rs.insert(range.first, range.second);
+  });
+  std::printf("%zu ranges, RangeSet::insert one by one: %.1f ms\n\n", count, serial_insert);
+
+  const auto a = HyoutaUtilities::coalesce_ranges_parallel(input);
+  const auto b = HyoutaUtilities::coalesce_ranges_parallel(other_input);
+
+  std::printf("%8s %12s %12s %12s %12s %12s\n", "threads", "coalesce ms", "build ms", "union ms", "intersect ms",
+              "speedup");
+  double baseline = 0.0;
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    const double coalesce = time_ms([&] { HyoutaUtilities::coalesce_ranges_parallel(input, threads); });
+    const double build = time_ms([&] { HyoutaUtilities::build_range_set_parallel(input, threads); });
+    const double unite = time_ms([&] { HyoutaUtilities::union_parallel(a, b, threads); });
+    const double intersect = time_ms([&] { HyoutaUtilities::intersection_parallel(a, b, threads); });
+    if (threads == 1)
+      baseline = coalesce + unite + intersect;
+    std::printf("%8u %12.1f %12.1f %12.1f %12.1f %11.2fx\n", threads, coalesce, build, unite, intersect,
+                baseline / (coalesce + unite + intersect));
+    if (threads < max_threads && threads * 2 > max_threads)
+      threads = max_threads / 2;
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Compares RadixRangeSet against RangeSet on ranges scattered over a sparse 48-bit address space.
+// Usage: bench_radix [largest range count]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "radixrangeset.h"
+#include "rangeset.h"
+
+template <typename F> static double ns_per_op(std::size_t count, F&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+template <typename Set>
+static void run(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& queries, double& insert_ns,
+                double& lookup_ns, double& erase_ns, std::size_t& hits) {
+  constexpr uint64_t PageSize = 4096;
+  Set set;
+  insert_ns = ns_per_op(starts.size(), [&] {
+    for (uint64_t start : starts)
+      set.insert(start, start + 4 * PageSize);
+  });
+  lookup_ns = ns_per_op(queries.size(), [&] {
+    std::size_t found = 0;
+    for (uint64_t query : queries)
+      found += set.contains(query) ? 1 : 0;
+    hits = found;
+  });
+  erase_ns = ns_per_op(starts.size(), [&] {
+    for (uint64_t start : starts)
+      set.erase(start + PageSize, start + 2 * PageSize);
+  });
+}
+
+int main(int argc, char** argv) {
+  const std::size_t largest = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  constexpr std::size_t QueryCount = 2000000;
+  constexpr uint64_t AddressSpace = uint64_t(1) << 48;
+
+  std::printf("%10s %12s %12s %12s %12s %12s %12s\n", "ranges", "map ins", "radix ins", "map find", "radix find",
+              "map erase", "radix erase");
+  for (std::size_t count = 10000; count <= largest; count *= 10) {
+    // Page aligned mappings at random places, with lookups biased towards them so they're not all misses.
+    std::mt19937_64 rng(count);
+    std::uniform_int_distribution<uint64_t> page(0, AddressSpace / 4096 - 16);
+    std::vector<uint64_t> starts(count);
+    for (auto& start : starts)
+      start = page(rng) * 4096;
+    std::vector<uint64_t> queries(QueryCount);
+    std::uniform_int_distribution<uint64_t> offset(0, 8 * 4096);
+    for (auto& query : queries)
+      query = starts[rng() % count] + offset(rng);
+
+    double map_insert, map_lookup, map_erase, radix_insert, radix_lookup, radix_erase;
+    std::size_t map_hits, radix_hits;
+    run<HyoutaUtilities::RangeSet<uint64_t>>(starts, queries, map_insert, map_lookup, map_erase, map_hits);
+    run<HyoutaUtilities::RadixRangeSet<uint64_t>>(starts, queries, radix_insert, radix_lookup, radix_erase,
+                                                  radix_hits);
+    if (map_hits != radix_hits) {
+      std::printf("lookup results differ!\n");
+      return 1;
+    }
+    std::printf("%10zu %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n", count, map_insert, radix_insert, map_lookup,
+                radix_lookup, map_erase, radix_erase);
+  }
+  return 0;
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitutils.h"
+
+namespace HyoutaUtilities {
+// Like RangeSet, but stores the set as a bitmap with one bit per value in [0, limit[, which is fixed on construction.
+// This is intended for page-granular tracking of a bounded space, eg. pass page numbers instead of addresses.
+// On top of the bitmap we keep two summary bitmaps with one bit per bitmap word, one marking the words that have any
+// bit set and one marking the words that have any bit clear, so runs can be found quickly even in sparse or
+// almost-full sets.
+template <typename T> class BitmapRangeSet {
+  static_assert(std::is_unsigned_v<T>, "BitmapRangeSet only supports unsigned integers.");
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return From;
+    }
+
+    const T& to() const {
+      return To;
+    }
+
+    const_iterator& operator++() {
+      const std::size_t next = Set->next_set(To);
+      if (next == Set->Limit) {
+        From = To = static_cast<T>(Set->Limit);
+      } else {
+        From = static_cast<T>(next);
+        To = static_cast<T>(Set->next_clear(next));
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    const_iterator& operator--() {
+      // The bit before 'From' is clear (or 'From' is the end), so the last set bit before it ends the previous range.
+      const std::size_t last = Set->prev_set(From);
+      assert(last != BitUtils::NoBit);
+      const std::size_t before = Set->prev_clear(last);
+      From = static_cast<T>(before == BitUtils::NoBit ? 0 : before + 1);
+      To = static_cast<T>(last + 1);
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      operator--();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->From == rhs.From;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    const BitmapRangeSet* Set;
+    T From;
+    T To;
+    const_iterator(const BitmapRangeSet* set, T from, T to) : Set(set), From(from), To(to) {}
+    friend class BitmapRangeSet;
+  };
+
+  // Creates an empty set that can hold values in [0, limit[.
+  explicit BitmapRangeSet(T limit)
+      : Limit(limit), Words((Limit + 63) / 64, 0), NonEmpty((Words.size() + 63) / 64, 0),
+        NonFull((Words.size() + 63) / 64, 0) {
+    BitUtils::set_bits(NonFull.data(), 0, Words.size());
+  }
+
+  // Values at or after the limit are ignored, like in erase().
+  void insert(T from, T to) {
+    if (from >= to)
+      return;
+    if (to > Limit)
+      to = static_cast<T>(Limit);
+    if (from >= to)
+      return;
+
+    const std::size_t window_end = to < Limit ? std::size_t(to) + 1 : Limit;
+    const std::size_t before = BitUtils::count_run_starts(Words.data(), from, window_end);
+    BitUtils::set_bits(Words.data(), from, to);
+    RunCount = RunCount - before + BitUtils::count_run_starts(Words.data(), from, window_end);
+    update_summary(from, to);
+  }
+
+  void erase(T from, T to) {
+    if (from >= to)
+      return;
+    if (to > Limit)
+      to = static_cast<T>(Limit);
+    if (from >= to)
+      return;
+
+    const std::size_t window_end = to < Limit ? std::size_t(to) + 1 : Limit;
+    const std::size_t before = BitUtils::count_run_starts(Words.data(), from, window_end);
+    BitUtils::clear_bits(Words.data(), from, to);
+    RunCount = RunCount - before + BitUtils::count_run_starts(Words.data(), from, window_end);
+    update_summary(from, to);
+  }
+
+  const_iterator erase(const_iterator it) {
+    const T to = it.to();
+    erase(it.from(), to);
+    return make_iterator(next_set(to));
+  }
+
+  void clear() {
+    std::fill(Words.begin(), Words.end(), 0);
+    std::fill(NonEmpty.begin(), NonEmpty.end(), 0);
+    BitUtils::set_bits(NonFull.data(), 0, Words.size());
+    RunCount = 0;
+  }
+
+  bool contains(T value) const {
+    return value < Limit && BitUtils::test_bit(Words.data(), value);
+  }
+
+  // Returns the range that contains the given value, or end() if there is none.
+  const_iterator find(T value) const {
+    if (!contains(value))
+      return end();
+    const std::size_t before = prev_clear(value);
+    return make_iterator(before == BitUtils::NoBit ? 0 : before + 1);
+  }
+
+  // Returns the first range that starts at or after the given value.
+  const_iterator lower_bound(T value) const {
+    return make_iterator(next_range_start(value));
+  }
+
+  // Returns the first range that starts after the given value.
+  const_iterator upper_bound(T value) const {
+    if (value >= Limit)
+      return end();
+    return make_iterator(next_range_start(static_cast<std::size_t>(value) + 1));
+  }
+
+  // Returns the start of the first run of at least 'count' values that are not in the set, or limit() if there is none.
+  T find_free(std::size_t count) const {
+    std::size_t pos = next_clear(0);
+    while (pos < Limit) {
+      const std::size_t end = next_set(pos);
+      if (end - pos >= count)
+        return static_cast<T>(pos);
+      pos = next_clear(end);
+    }
+    return static_cast<T>(Limit);
+  }
+
+  std::size_t size() const {
+    return RunCount;
+  }
+
+  bool empty() const {
+    return RunCount == 0;
+  }
+
+  T limit() const {
+    return static_cast<T>(Limit);
+  }
+
+  // Bytes used by the bitmap and its summaries.
+  std::size_t memory_usage() const {
+    return (Words.size() + NonEmpty.size() + NonFull.size()) * sizeof(uint64_t);
+  }
+
+  void swap(BitmapRangeSet<T>& other) {
+    std::swap(Limit, other.Limit);
+    Words.swap(other.Words);
+    NonEmpty.swap(other.NonEmpty);
+    NonFull.swap(other.NonFull);
+    std::swap(RunCount, other.RunCount);
+  }
+
+  const_iterator begin() const {
+    return make_iterator(next_set(0));
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, static_cast<T>(Limit), static_cast<T>(Limit));
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  bool operator==(const BitmapRangeSet<T>& other) const {
+    if (this->Limit == other.Limit)
+      return this->Words == other.Words;
+    auto a = this->begin();
+    auto b = other.begin();
+    for (; a != this->end() && b != other.end(); ++a, ++b) {
+      if (a.from() != b.from() || a.to() != b.to())
+        return false;
+    }
+    return a == this->end() && b == other.end();
+  }
+
+  bool operator!=(const BitmapRangeSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    std::size_t free_total = 0;
+    if (begin() == end())
+      return {free_total, 1.0};
+    std::size_t largest_size = 0;
+    for (auto iter = begin(); iter != end(); ++iter) {
+      const std::size_t size = static_cast<std::size_t>(iter.to() - iter.from());
+      if (size > largest_size)
+        largest_size = size;
+      free_total += size;
+    }
+    return {free_total, static_cast<double>(free_total - largest_size) / free_total};
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Bit 'i' of 'Words' is set if and only if 'i' is in the set.
+  // - Bits at or after 'Limit' are always clear.
+  // - Bit 'i' of 'NonEmpty' is set if and only if Words[i] has any bit set.
+  // - Bit 'i' of 'NonFull' is set if and only if Words[i] has any bit clear.
+  // - 'RunCount' is the number of maximal runs of set bits in 'Words'.
+  std::size_t Limit;
+  std::vector<uint64_t> Words;
+  std::vector<uint64_t> NonEmpty;
+  std::vector<uint64_t> NonFull;
+  std::size_t RunCount = 0;
+
+  const_iterator make_iterator(std::size_t from) const {
+    if (from >= Limit)
+      return end();
+    return const_iterator(this, static_cast<T>(from), static_cast<T>(next_clear(from)));
+  }
+
+  void update_summary(std::size_t from, std::size_t to) {
+    const std::size_t first = from / 64;
+    const std::size_t last = (to - 1) / 64;
+    for (std::size_t i = first; i <= last; ++i) {
+      const uint64_t bit = uint64_t(1) << (i % 64);
+      if (Words[i] != 0)
+        NonEmpty[i / 64] |= bit;
+      else
+        NonEmpty[i / 64] &= ~bit;
+      if (Words[i] != ~uint64_t(0))
+        NonFull[i / 64] |= bit;
+      else
+        NonFull[i / 64] &= ~bit;
+    }
+  }
+
+  // First value at or after 'pos' that starts a range, or Limit if there is none.
+  std::size_t next_range_start(std::size_t pos) const {
+    if (pos >= Limit)
+      return Limit;
+
+    // If 'pos' is in the middle of a range, that one doesn't count, so skip to its end first.
+    if (pos > 0 && BitUtils::test_bit(Words.data(), pos - 1))
+      pos = next_clear(pos);
+    return next_set(pos);
+  }
+
+  // First value at or after 'pos' that is in the set, or Limit if there is none.
+  std::size_t next_set(std::size_t pos) const {
+    if (pos >= Limit)
+      return Limit;
+    std::size_t i = pos / 64;
+    uint64_t word = Words[i] & (~uint64_t(0) << (pos % 64));
+    if (word == 0) {
+      i = BitUtils::find_next_set(NonEmpty.data(), i + 1, Words.size());
+      if (i == Words.size())
+        return Limit;
+      word = Words[i];
+    }
+    return i * 64 + BitUtils::count_trailing_zeros(word);
+  }
+
+  // First value at or after 'pos' that is not in the set, or Limit if there is none.
+  std::size_t next_clear(std::size_t pos) const {
+    if (pos >= Limit)
+      return Limit;
+    std::size_t i = pos / 64;
+    uint64_t word = ~Words[i] & (~uint64_t(0) << (pos % 64));
+    if (word == 0) {
+      i = BitUtils::find_next_set(NonFull.data(), i + 1, Words.size());
+      if (i == Words.size())
+        return Limit;
+      word = ~Words[i];
+    }
+    const std::size_t result = i * 64 + BitUtils::count_trailing_zeros(word);
+    return result < Limit ? result : Limit;
+  }
+
+  // Last value before 'pos' that is in the set, or NoBit if there is none.
+  std::size_t prev_set(std::size_t pos) const {
+    if (pos == 0)
+      return BitUtils::NoBit;
+    std::size_t i = (pos - 1) / 64;
+    uint64_t word = Words[i] & BitUtils::word_mask(0, (pos - 1) % 64 + 1);
+    if (word == 0) {
+      i = BitUtils::find_prev_set(NonEmpty.data(), i);
+      if (i == BitUtils::NoBit)
+        return BitUtils::NoBit;
+      word = Words[i];
+    }
+    return i * 64 + 63 - BitUtils::count_leading_zeros(word);
+  }
+
+  // Last value before 'pos' that is not in the set, or NoBit if there is none.
+  std::size_t prev_clear(std::size_t pos) const {
+    if (pos == 0)
+      return BitUtils::NoBit;
+    std::size_t i = (pos - 1) / 64;
+    uint64_t word = ~Words[i] & BitUtils::word_mask(0, (pos - 1) % 64 + 1);
+    if (word == 0) {
+      i = BitUtils::find_prev_set(NonFull.data(), i);
+      if (i == BitUtils::NoBit)
+        return BitUtils::NoBit;
+      word = ~Words[i];
+    }
+    return i * 64 + 63 - BitUtils::count_leading_zeros(word);
+  }
+};
+} // namespace HyoutaUtilities
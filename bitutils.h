@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace HyoutaUtilities {
+// Helpers for working with bitmaps stored as arrays of 64-bit words, where bit 'i' is bit 'i % 64' of word 'i / 64'.
+namespace BitUtils {
+// Index of the lowest set bit. 'value' must not be zero.
+inline int count_trailing_zeros(uint64_t value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+// Number of clear bits above the highest set bit. 'value' must not be zero.
+inline int count_leading_zeros(uint64_t value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return 63 - static_cast<int>(index);
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
+inline int popcount(uint64_t value) {
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt64(value));
+#else
+  return __builtin_popcountll(value);
+#endif
+}
+
+// Mask of the bits of a single word that lie within [from, to[, where 0 <= from < to <= 64.
+inline uint64_t word_mask(std::size_t from, std::size_t to) {
+  const uint64_t upper = to == 64 ? ~uint64_t(0) : ((uint64_t(1) << to) - 1);
+  return upper & (~uint64_t(0) << from);
+}
+
+// Calls fn(word_index, mask) for every word overlapping the bits [from, to[.
+template <typename F> void for_each_word(std::size_t from, std::size_t to, F&& fn) {
+  if (from >= to)
+    return;
+  const std::size_t first = from / 64;
+  const std::size_t last = (to - 1) / 64;
+  if (first == last) {
+    fn(first, word_mask(from % 64, (to - 1) % 64 + 1));
+    return;
+  }
+  fn(first, word_mask(from % 64, 64));
+  for (std::size_t i = first + 1; i < last; ++i)
+    fn(i, ~uint64_t(0));
+  fn(last, word_mask(0, (to - 1) % 64 + 1));
+}
+
+inline void set_bits(uint64_t* words, std::size_t from, std::size_t to) {
+  for_each_word(from, to, [&](std::size_t i, uint64_t mask) { words[i] |= mask; });
+}
+
+inline void clear_bits(uint64_t* words, std::size_t from, std::size_t to) {
+  for_each_word(from, to, [&](std::size_t i, uint64_t mask) { words[i] &= ~mask; });
+}
+
+inline bool test_bit(const uint64_t* words, std::size_t index) {
+  return (words[index / 64] >> (index % 64)) & 1;
+}
+
+// Returns the index of the first non-zero word in [index, count[, or 'count' if they're all zero.
+inline std::size_t find_next_nonzero_word(const uint64_t* words, std::size_t index, std::size_t count) {
+#ifdef __AVX2__
+  // Check four words at a time.
+  while (index + 4 <= count) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + index));
+    if (!_mm256_testz_si256(v, v))
+      break;
+    index += 4;
+  }
+#endif
+  while (index < count && words[index] == 0)
+    ++index;
+  return index;
+}
+
+// Returns the first set bit at or after 'pos', or 'limit' if there is none before 'limit'.
+inline std::size_t find_next_set(const uint64_t* words, std::size_t pos, std::size_t limit) {
+  if (pos >= limit)
+    return limit;
+  std::size_t i = pos / 64;
+  uint64_t word = words[i] & (~uint64_t(0) << (pos % 64));
+  if (word == 0) {
+    const std::size_t word_count = (limit + 63) / 64;
+    i = find_next_nonzero_word(words, i + 1, word_count);
+    if (i == word_count)
+      return limit;
+    word = words[i];
+  }
+  const std::size_t result = i * 64 + count_trailing_zeros(word);
+  return result < limit ? result : limit;
+}
+
+// Returns the first clear bit at or after 'pos', or 'limit' if there is none before 'limit'.
+inline std::size_t find_next_clear(const uint64_t* words, std::size_t pos, std::size_t limit) {
+  if (pos >= limit)
+    return limit;
+  std::size_t i = pos / 64;
+  uint64_t word = ~words[i] & (~uint64_t(0) << (pos % 64));
+  while (word == 0) {
+    ++i;
+    if (i * 64 >= limit)
+      return limit;
+    word = ~words[i];
+  }
+  const std::size_t result = i * 64 + count_trailing_zeros(word);
+  return result < limit ? result : limit;
+}
+
+// Returned by find_prev_set() and find_prev_clear() if there is no such bit.
+constexpr std::size_t NoBit = ~std::size_t(0);
+
+// Returns the last set bit before 'pos', or NoBit if there is none.
+inline std::size_t find_prev_set(const uint64_t* words, std::size_t pos) {
+  if (pos == 0)
+    return NoBit;
+  std::size_t i = (pos - 1) / 64;
+  uint64_t word = words[i] & word_mask(0, (pos - 1) % 64 + 1);
+  while (word == 0) {
+    if (i == 0)
+      return NoBit;
+    --i;
+    word = words[i];
+  }
+  return i * 64 + 63 - count_leading_zeros(word);
+}
+
+// Returns the last clear bit before 'pos', or NoBit if there is none.
+inline std::size_t find_prev_clear(const uint64_t* words, std::size_t pos) {
+  if (pos == 0)
+    return NoBit;
+  std::size_t i = (pos - 1) / 64;
+  uint64_t word = ~words[i] & word_mask(0, (pos - 1) % 64 + 1);
+  while (word == 0) {
+    if (i == 0)
+      return NoBit;
+    --i;
+    word = ~words[i];
+  }
+  return i * 64 + 63 - count_leading_zeros(word);
+}
+
+// Counts the set bits within [from, to[ that start a run of set bits, ie. whose preceding bit is clear.
+inline std::size_t count_run_starts(const uint64_t* words, std::size_t from, std::size_t to) {
+  std::size_t count = 0;
+  for_each_word(from, to, [&](std::size_t i, uint64_t mask) {
+    const uint64_t carry = i > 0 ? words[i - 1] >> 63 : 0;
+    const uint64_t starts = words[i] & ~((words[i] << 1) | carry);
+    count += static_cast<std::size_t>(popcount(starts & mask));
+  });
+  return count;
+}
+} // namespace BitUtils
+} // namespace HyoutaUtilities
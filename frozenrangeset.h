@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitutils.h"
+#include "rangeset.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace HyoutaUtilities {
+// Immutable copy of a RangeSet that is optimized for lookups.
+// The ranges are stored in a single array in Eytzinger order, that is, the sorted ranges are laid out like an implicit
+// binary search tree in breadth-first order: the root is at index 1 and the children of index 'k' are at '2k' and
+// '2k + 1'. A lookup then walks down that tree without any data-dependent branches, the top levels are shared by all
+// lookups and stay in cache, and the descendants a few levels further down are adjacent in memory, so they can be
+// prefetched before they are needed.
+template <typename T> class FrozenRangeSet {
+private:
+  struct Entry {
+    T From;
+    T To;
+  };
+
+  // How many entries share a cache line, and thus how far ahead the descendants are prefetched.
+  static constexpr std::size_t EntriesPerCacheLine = sizeof(Entry) < 64 ? 64 / sizeof(Entry) : 1;
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return Set->Entries[Index].From;
+    }
+
+    const T& to() const {
+      return Set->Entries[Index].To;
+    }
+
+    const_iterator& operator++() {
+      Index = Set->next_index(Index);
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    const_iterator& operator--() {
+      Index = Set->prev_index(Index);
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      operator--();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->Index == rhs.Index;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    const FrozenRangeSet* Set;
+    std::size_t Index;
+    const_iterator(const FrozenRangeSet* set, std::size_t index) : Set(set), Index(index) {}
+    friend class FrozenRangeSet;
+  };
+
+  FrozenRangeSet() : Entries(1) {}
+
+  template <typename Observer> explicit FrozenRangeSet(const RangeSet<T, Observer>& rs) : Entries(rs.size() + 1) {
+    auto it = rs.begin();
+    fill(1, it);
+  }
+
+  bool contains(T value) const {
+    const std::size_t index = predecessor(value);
+    return index != 0 && value < Entries[index].To;
+  }
+
+  // Returns the range that contains the given value, or end() if there is none.
+  const_iterator find(T value) const {
+    const std::size_t index = predecessor(value);
+    if (index != 0 && value < Entries[index].To)
+      return const_iterator(this, index);
+    return end();
+  }
+
+  std::size_t size() const {
+    return Entries.size() - 1;
+  }
+
+  bool empty() const {
+    return Entries.size() == 1;
+  }
+
+  // Bytes used by the lookup array.
+  std::size_t memory_usage() const {
+    return Entries.size() * sizeof(Entry);
+  }
+
+  void swap(FrozenRangeSet<T>& other) {
+    Entries.swap(other.Entries);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, first_index());
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  bool operator==(const FrozenRangeSet<T>& other) const {
+    // The layout only depends on the number of ranges, so equal sets have equal arrays.
+    if (this->Entries.size() != other.Entries.size())
+      return false;
+    for (std::size_t i = 1; i < this->Entries.size(); ++i) {
+      if (this->Entries[i].From != other.Entries[i].From || this->Entries[i].To != other.Entries[i].To)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const FrozenRangeSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    std::size_t free_total = 0;
+    if (begin() == end())
+      return {free_total, 1.0};
+    std::size_t largest_size = 0;
+    for (std::size_t i = 1; i < Entries.size(); ++i) {
+      const std::size_t size = calc_size(Entries[i].From, Entries[i].To);
+      if (size > largest_size)
+        largest_size = size;
+      free_total += size;
+    }
+    return {free_total, static_cast<double>(free_total - largest_size) / free_total};
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Ranges are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is always smaller than 'to'
+  // - Stored ranges never touch.
+  // - Stored ranges never overlap.
+  // - Entries[0] is unused, Entries[1 .. size()] are the ranges in Eytzinger order.
+  std::vector<Entry> Entries;
+
+  static std::size_t calc_size(T from, T to) {
+    if constexpr (std::is_pointer_v<T>) {
+      // For pointers we don't want pointer arithmetic here, else void* breaks.
+      return reinterpret_cast<std::size_t>(to) - reinterpret_cast<std::size_t>(from);
+    } else {
+      return static_cast<std::size_t>(to - from);
+    }
+  }
+
+  // Fills the subtree at 'k' from the sorted ranges, in order.
+  template <typename It> void fill(std::size_t k, It& it) {
+    if (k >= Entries.size())
+      return;
+    fill(2 * k, it);
+    Entries[k].From = it.from();
+    Entries[k].To = it.to();
+    ++it;
+    fill(2 * k + 1, it);
+  }
+
+  void prefetch(std::size_t k) const {
+    // Clamp instead of branching so the address stays within the array.
+    const std::size_t last = Entries.size() - 1;
+    const Entry* address = Entries.data() + (k < last ? k : last);
+#ifdef _MSC_VER
+    _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#else
+    __builtin_prefetch(address);
+#endif
+  }
+
+  // Index of the range with the largest start at or before 'value', or 0 if there is none.
+  std::size_t predecessor(T value) const {
+    const std::size_t count = Entries.size() - 1;
+    std::size_t k = 1;
+    while (k <= count) {
+      prefetch(k * EntriesPerCacheLine);
+      // Go right if this range starts at or before 'value', left otherwise.
+      k = 2 * k + static_cast<std::size_t>(!(value < Entries[k].From));
+    }
+    // The bits of 'k' now spell out the path taken, with 1 for every right turn. The predecessor is the node of the
+    // last right turn, so drop the trailing left turns and that right turn itself.
+    return k >> (BitUtils::count_trailing_zeros(static_cast<uint64_t>(k)) + 1);
+  }
+
+  std::size_t first_index() const {
+    if (empty())
+      return 0;
+    std::size_t k = 1;
+    while (2 * k < Entries.size())
+      k = 2 * k;
+    return k;
+  }
+
+  std::size_t next_index(std::size_t k) const {
+    if (2 * k + 1 < Entries.size()) {
+      // Leftmost node of the right subtree.
+      k = 2 * k + 1;
+      while (2 * k < Entries.size())
+        k = 2 * k;
+      return k;
+    }
+    // Go up past all nodes we're the right child of, then once more.
+    return k >> (BitUtils::count_trailing_zeros(~static_cast<uint64_t>(k)) + 1);
+  }
+
+  std::size_t prev_index(std::size_t k) const {
+    if (k == 0) {
+      // Rightmost node of the whole tree.
+      k = 1;
+      while (2 * k + 1 < Entries.size())
+        k = 2 * k + 1;
+      return k;
+    }
+    if (2 * k < Entries.size()) {
+      // Rightmost node of the left subtree.
+      k = 2 * k;
+      while (2 * k + 1 < Entries.size())
+        k = 2 * k + 1;
+      return k;
+    }
+    // Go up past all nodes we're the left child of, then once more.
+    return k >> (BitUtils::count_trailing_zeros(static_cast<uint64_t>(k)) + 1);
+  }
+};
+
+// Creates an immutable copy of the given set that is optimized for lookups.
+template <typename T, typename Observer> FrozenRangeSet<T> freeze(const RangeSet<T, Observer>& rs) {
+  return FrozenRangeSet<T>(rs);
+}
+} // namespace HyoutaUtilities
@@ -0,0 +1,463 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitutils.h"
+#include "rangeset.h"
+
+namespace HyoutaUtilities {
+// Like RangeSet, but splits the key space into chunks of 64 Ki values and stores each chunk either as a list of runs
+// (a RangeSet, like usual) or as a bitmap, depending on which is smaller. Sets that consist of huge amounts of tiny
+// ranges thus cost at most one bit per possible value instead of one std::map node per range.
+// Only unsigned integer types are supported. Iteration yields maximal ranges, merged across chunk boundaries, but can
+// only go forward.
+template <typename T> class HybridRangeSet {
+  static_assert(std::is_unsigned_v<T>, "HybridRangeSet only supports unsigned integers.");
+
+public:
+  // Number of low bits of each value that are used as the position within its chunk.
+  static constexpr unsigned ChunkBits = 16;
+  static constexpr std::size_t ChunkSize = std::size_t(1) << ChunkBits;
+
+  // A run-list chunk switches to a bitmap once it holds more than this many runs...
+  static constexpr std::size_t MaxRunsBeforeBitmap = 256;
+
+  // ...and a bitmap chunk switches back once it holds fewer than this many runs.
+  static constexpr std::size_t MinRunsBeforeRuns = 128;
+
+private:
+  // Positions within a chunk go up to and including ChunkSize for the exclusive end, so they don't fit in 16 bits.
+  using LocalT = uint32_t;
+
+  struct Chunk {
+    // Used while this chunk is a run list.
+    RangeSet<LocalT> Runs;
+
+    // Used while this chunk is a bitmap, empty otherwise.
+    std::vector<uint64_t> Bits;
+
+    // Number of runs in 'Bits', kept up to date so we know when to switch back to a run list.
+    std::size_t BitRuns = 0;
+
+    bool is_bitmap() const {
+      return !Bits.empty();
+    }
+
+    bool empty() const {
+      return is_bitmap() ? BitRuns == 0 : Runs.empty();
+    }
+
+    std::size_t run_count() const {
+      return is_bitmap() ? BitRuns : Runs.size();
+    }
+
+    bool contains(LocalT pos) const {
+      return is_bitmap() ? BitUtils::test_bit(Bits.data(), pos) : Runs.contains(pos);
+    }
+
+    void insert(LocalT from, LocalT to) {
+      if (!is_bitmap()) {
+        Runs.insert(from, to);
+        return;
+      }
+
+      // Setting bits can only change whether a run starts within [from, to].
+      const std::size_t window_end = to < ChunkSize ? to + 1 : ChunkSize;
+      const std::size_t before = BitUtils::count_run_starts(Bits.data(), from, window_end);
+      BitUtils::set_bits(Bits.data(), from, to);
+      BitRuns = BitRuns - before + BitUtils::count_run_starts(Bits.data(), from, window_end);
+    }
+
+    void erase(LocalT from, LocalT to) {
+      if (!is_bitmap()) {
+        Runs.erase(from, to);
+        return;
+      }
+
+      const std::size_t window_end = to < ChunkSize ? to + 1 : ChunkSize;
+      const std::size_t before = BitUtils::count_run_starts(Bits.data(), from, window_end);
+      BitUtils::clear_bits(Bits.data(), from, to);
+      BitRuns = BitRuns - before + BitUtils::count_run_starts(Bits.data(), from, window_end);
+    }
+
+    // First position at or after 'pos' that is in the set, or ChunkSize if there is none.
+    std::size_t next_set(std::size_t pos) const {
+      if (is_bitmap())
+        return BitUtils::find_next_set(Bits.data(), pos, ChunkSize);
+      if (Runs.contains(static_cast<LocalT>(pos)))
+        return pos;
+      auto it = Runs.upper_bound(static_cast<LocalT>(pos));
+      return it == Runs.end() ? ChunkSize : it.from();
+    }
+
+    // First position at or after 'pos' that is not in the set, or ChunkSize if there is none.
+    std::size_t next_clear(std::size_t pos) const {
+      if (is_bitmap())
+        return BitUtils::find_next_clear(Bits.data(), pos, ChunkSize);
+      auto it = Runs.find(static_cast<LocalT>(pos));
+      return it == Runs.end() ? pos : it.to();
+    }
+
+    // Calls fn(from, to) for every run in this chunk, in ascending order.
+    template <typename F> void for_each_run(F&& fn) const {
+      if (!is_bitmap()) {
+        for (auto it = Runs.begin(); it != Runs.end(); ++it)
+          fn(it.from(), it.to());
+        return;
+      }
+      std::size_t pos = BitUtils::find_next_set(Bits.data(), 0, ChunkSize);
+      while (pos < ChunkSize) {
+        const std::size_t end = BitUtils::find_next_clear(Bits.data(), pos, ChunkSize);
+        fn(static_cast<LocalT>(pos), static_cast<LocalT>(end));
+        pos = BitUtils::find_next_set(Bits.data(), end, ChunkSize);
+      }
+    }
+
+    void to_bitmap() {
+      Bits.assign(ChunkSize / 64, 0);
+      for (auto it = Runs.begin(); it != Runs.end(); ++it)
+        BitUtils::set_bits(Bits.data(), it.from(), it.to());
+      BitRuns = Runs.size();
+      Runs.clear();
+    }
+
+    void to_runs() {
+      for_each_run([&](LocalT from, LocalT to) { Runs.insert(from, to); });
+      std::vector<uint64_t>().swap(Bits);
+      BitRuns = 0;
+    }
+
+    // Recounts the runs after the bitmap was modified through word operations.
+    void recount() {
+      BitRuns = BitUtils::count_run_starts(Bits.data(), 0, ChunkSize);
+    }
+
+    void maybe_convert() {
+      if (!is_bitmap() && Runs.size() > MaxRunsBeforeBitmap)
+        to_bitmap();
+      else if (is_bitmap() && BitRuns < MinRunsBeforeRuns)
+        to_runs();
+    }
+  };
+
+  using MapT = std::map<T, Chunk>;
+
+public:
+  struct const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+
+    const T& from() const {
+      return From;
+    }
+
+    const T& to() const {
+      return To;
+    }
+
+    const_iterator& operator++() {
+      std::size_t next = Set->next_set(To);
+      if (next == NoValue)
+        Set = nullptr;
+      else
+        *this = Set->range_at(next);
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      if (this->Set == nullptr || rhs.Set == nullptr)
+        return this->Set == rhs.Set;
+      return this->From == rhs.From;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    // nullptr for end().
+    const HybridRangeSet* Set;
+    T From;
+    T To;
+    const_iterator(const HybridRangeSet* set, T from, T to) : Set(set), From(from), To(to) {}
+    friend class HybridRangeSet;
+  };
+
+  void insert(T from, T to) {
+    if (from >= to)
+      return;
+
+    for_each_chunk_piece(from, to, [&](T index, LocalT lfrom, LocalT lto) {
+      Chunk& chunk = Chunks[index];
+      chunk.insert(lfrom, lto);
+      chunk.maybe_convert();
+    });
+  }
+
+  void erase(T from, T to) {
+    if (from >= to)
+      return;
+
+    for_each_chunk_piece(from, to, [&](T index, LocalT lfrom, LocalT lto) {
+      auto it = Chunks.find(index);
+      if (it == Chunks.end())
+        return;
+      it->second.erase(lfrom, lto);
+      if (it->second.empty())
+        Chunks.erase(it);
+      else
+        it->second.maybe_convert();
+    });
+  }
+
+  // Adds all ranges of 'other' to this set.
+  void insert(const HybridRangeSet<T>& other) {
+    for (const auto& [index, ochunk] : other.Chunks) {
+      Chunk& chunk = Chunks[index];
+      if (chunk.is_bitmap() && ochunk.is_bitmap()) {
+        for (std::size_t i = 0; i < chunk.Bits.size(); ++i)
+          chunk.Bits[i] |= ochunk.Bits[i];
+        chunk.recount();
+      } else {
+        ochunk.for_each_run([&](LocalT lfrom, LocalT lto) { chunk.insert(lfrom, lto); });
+      }
+      chunk.maybe_convert();
+    }
+  }
+
+  // Removes all ranges of 'other' from this set.
+  void erase(const HybridRangeSet<T>& other) {
+    for (const auto& [index, ochunk] : other.Chunks) {
+      auto it = Chunks.find(index);
+      if (it == Chunks.end())
+        continue;
+      Chunk& chunk = it->second;
+      if (chunk.is_bitmap() && ochunk.is_bitmap()) {
+        for (std::size_t i = 0; i < chunk.Bits.size(); ++i)
+          chunk.Bits[i] &= ~ochunk.Bits[i];
+        chunk.recount();
+      } else {
+        ochunk.for_each_run([&](LocalT lfrom, LocalT lto) { chunk.erase(lfrom, lto); });
+      }
+      if (chunk.empty())
+        Chunks.erase(it);
+      else
+        chunk.maybe_convert();
+    }
+  }
+
+  // Removes everything from this set that isn't also in 'other'.
+  void intersect(const HybridRangeSet<T>& other) {
+    for (auto it = Chunks.begin(); it != Chunks.end();) {
+      auto oit = other.Chunks.find(it->first);
+      if (oit == other.Chunks.end()) {
+        it = Chunks.erase(it);
+        continue;
+      }
+      Chunk& chunk = it->second;
+      const Chunk& ochunk = oit->second;
+      if (chunk.is_bitmap() && ochunk.is_bitmap()) {
+        for (std::size_t i = 0; i < chunk.Bits.size(); ++i)
+          chunk.Bits[i] &= ochunk.Bits[i];
+        chunk.recount();
+      } else {
+        // Erase all the gaps between the runs of the other chunk.
+        std::size_t gap_from = 0;
+        ochunk.for_each_run([&](LocalT lfrom, LocalT lto) {
+          if (gap_from < lfrom)
+            chunk.erase(static_cast<LocalT>(gap_from), lfrom);
+          gap_from = lto;
+        });
+        if (gap_from < ChunkSize)
+          chunk.erase(static_cast<LocalT>(gap_from), static_cast<LocalT>(ChunkSize));
+      }
+      if (chunk.empty()) {
+        it = Chunks.erase(it);
+      } else {
+        chunk.maybe_convert();
+        ++it;
+      }
+    }
+  }
+
+  void clear() {
+    Chunks.clear();
+  }
+
+  bool contains(T value) const {
+    auto it = Chunks.find(chunk_index(value));
+    return it != Chunks.end() && it->second.contains(local_pos(value));
+  }
+
+  // Number of maximal ranges in this set. Takes time linear in the number of chunks.
+  std::size_t size() const {
+    std::size_t count = 0;
+    const Chunk* prev = nullptr;
+    T prev_index = 0;
+    for (const auto& [index, chunk] : Chunks) {
+      count += chunk.run_count();
+      // A run ending at the end of the previous chunk continues into a run at the start of this one.
+      if (prev && prev_index + 1 == index && prev->contains(ChunkSize - 1) && chunk.contains(0))
+        --count;
+      prev = &chunk;
+      prev_index = index;
+    }
+    return count;
+  }
+
+  bool empty() const {
+    return Chunks.empty();
+  }
+
+  // Number of chunks that are currently stored as bitmaps.
+  std::size_t bitmap_chunk_count() const {
+    std::size_t count = 0;
+    for (const auto& [index, chunk] : Chunks) {
+      if (chunk.is_bitmap())
+        ++count;
+    }
+    return count;
+  }
+
+  void swap(HybridRangeSet<T>& other) {
+    Chunks.swap(other.Chunks);
+  }
+
+  const_iterator begin() const {
+    std::size_t first = next_set(0);
+    if (first == NoValue)
+      return end();
+    return range_at(first);
+  }
+
+  const_iterator end() const {
+    return const_iterator(nullptr, T(), T());
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  bool operator==(const HybridRangeSet<T>& other) const {
+    // The same set may be stored with different representations, so compare range by range.
+    auto a = this->begin();
+    auto b = other.begin();
+    for (; a != this->end() && b != other.end(); ++a, ++b) {
+      if (a.from() != b.from() || a.to() != b.to())
+        return false;
+    }
+    return a == this->end() && b == other.end();
+  }
+
+  bool operator!=(const HybridRangeSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    std::size_t free_total = 0;
+    if (begin() == end())
+      return {free_total, 1.0};
+    std::size_t largest_size = 0;
+    for (auto iter = begin(); iter != end(); ++iter) {
+      const std::size_t size = static_cast<std::size_t>(iter.to() - iter.from());
+      if (size > largest_size)
+        largest_size = size;
+      free_total += size;
+    }
+    return {free_total, static_cast<double>(free_total - largest_size) / free_total};
+  }
+
+private:
+  // Returned by next_set() if there is no further value in the set.
+  static constexpr std::size_t NoValue = ~std::size_t(0);
+
+  // Assumptions that can be made about the data:
+  // - The map key is the chunk index, that is, the value shifted right by ChunkBits.
+  // - Each chunk stores the positions within the chunk that are in the set.
+  // - Chunks are never empty, empty chunks are removed from the map.
+  MapT Chunks;
+
+  static T chunk_index(T value) {
+    return static_cast<T>(static_cast<uint64_t>(value) >> ChunkBits);
+  }
+
+  static LocalT local_pos(T value) {
+    return static_cast<LocalT>(static_cast<uint64_t>(value) & (ChunkSize - 1));
+  }
+
+  static uint64_t chunk_base(T index) {
+    return static_cast<uint64_t>(index) << ChunkBits;
+  }
+
+  // Calls fn(chunk_index, local_from, local_to) for each chunk overlapping [from, to[.
+  template <typename F> static void for_each_chunk_piece(T from, T to, F&& fn) {
+    const T first = chunk_index(from);
+    const T last = chunk_index(static_cast<T>(to - 1));
+    for (T index = first;; ++index) {
+      const LocalT lfrom = index == first ? local_pos(from) : 0;
+      const LocalT lto = index == last ? local_pos(static_cast<T>(to - 1)) + 1 : static_cast<LocalT>(ChunkSize);
+      fn(index, lfrom, lto);
+      if (index == last)
+        break;
+    }
+  }
+
+  // First value at or after 'pos' that is in the set, or NoValue if there is none.
+  std::size_t next_set(uint64_t pos) const {
+    auto it = Chunks.lower_bound(static_cast<T>(pos >> ChunkBits));
+    if (it == Chunks.end())
+      return NoValue;
+    if (chunk_base(it->first) <= pos) {
+      const std::size_t local = it->second.next_set(pos & (ChunkSize - 1));
+      if (local < ChunkSize)
+        return chunk_base(it->first) + local;
+      ++it;
+      if (it == Chunks.end())
+        return NoValue;
+    }
+    // Chunks are never empty, so this always finds something.
+    return chunk_base(it->first) + it->second.next_set(0);
+  }
+
+  // First value at or after 'pos' that is not in the set.
+  uint64_t next_clear(uint64_t pos) const {
+    auto it = Chunks.find(static_cast<T>(pos >> ChunkBits));
+    while (it != Chunks.end()) {
+      const std::size_t local = it->second.next_clear(pos & (ChunkSize - 1));
+      if (local < ChunkSize)
+        return chunk_base(it->first) + local;
+
+      // This chunk is set until its end, so continue in the next chunk if it directly follows.
+      pos = chunk_base(it->first) + ChunkSize;
+      auto next = std::next(it);
+      if (next == Chunks.end() || chunk_base(next->first) != pos)
+        return pos;
+      it = next;
+    }
+    return pos;
+  }
+
+  // Returns an iterator to the maximal range starting at 'from', which must be the start of a range.
+  const_iterator range_at(uint64_t from) const {
+    return const_iterator(this, static_cast<T>(from), static_cast<T>(next_clear(from)));
+  }
+};
+} // namespace HyoutaUtilities
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace HyoutaUtilities {
+// Unlike RangeSet, stores every inserted interval individually along with a value, even if it overlaps or touches
+// other intervals. This allows asking which intervals contain a given point or overlap a given range.
+// Intervals are stored in a treap ordered by their start, where each node additionally remembers the largest end of
+// any interval in its subtree, so whole subtrees that end before the queried point can be skipped.
+template <typename T, typename V> class IntervalTree {
+private:
+  struct Node {
+    // Interval stored in this node, in the form [From, To[.
+    T From;
+    T To;
+    V Val;
+
+    // Largest 'To' of any interval in this subtree.
+    T MaxTo;
+
+    // Random heap priority that keeps the tree balanced.
+    uint32_t Priority;
+
+    std::unique_ptr<Node> Left;
+    std::unique_ptr<Node> Right;
+
+    Node(T from, T to, V val, uint32_t priority)
+        : From(from), To(to), Val(std::move(val)), MaxTo(to), Priority(priority) {}
+  };
+
+  using NodePtr = std::unique_ptr<Node>;
+
+public:
+  IntervalTree() = default;
+  IntervalTree(const IntervalTree<T, V>& other) : Root(clone(other.Root)), Count(other.Count), Seed(other.Seed) {}
+  IntervalTree(IntervalTree<T, V>&&) = default;
+  IntervalTree<T, V>& operator=(const IntervalTree<T, V>& other) {
+    if (this != &other) {
+      Root = clone(other.Root);
+      Count = other.Count;
+      Seed = other.Seed;
+    }
+    return *this;
+  }
+  IntervalTree<T, V>& operator=(IntervalTree<T, V>&&) = default;
+
+  // Stores the interval [from, to[ with the given value. Identical intervals may be stored multiple times.
+  void insert(T from, T to, V value) {
+    if (from >= to)
+      return;
+
+    NodePtr node = std::make_unique<Node>(from, to, std::move(value), next_priority());
+    auto parts = split(std::move(Root), from, to);
+    Root = merge(merge(std::move(parts.first), std::move(node)), std::move(parts.second));
+    ++Count;
+  }
+
+  // Removes one interval [from, to[ with the given value. Returns false if there was no such interval.
+  bool erase(T from, T to, const V& value) {
+    if (erase_node(Root, from, to, value)) {
+      --Count;
+      return true;
+    }
+    return false;
+  }
+
+  void clear() {
+    Root.reset();
+    Count = 0;
+  }
+
+  // Calls fn(from, to, value) for every interval that contains the given point, ordered by their start.
+  template <typename F> void for_each_containing(T point, F&& fn) const {
+    visit_containing(Root.get(), point, fn);
+  }
+
+  // Calls fn(from, to, value) for every interval that overlaps [from, to[, ordered by their start.
+  template <typename F> void for_each_overlapping(T from, T to, F&& fn) const {
+    if (from >= to)
+      return;
+    visit_overlapping(Root.get(), from, to, fn);
+  }
+
+  // Calls fn(from, to, value) for every interval, ordered by their start.
+  template <typename F> void for_each(F&& fn) const {
+    visit_all(Root.get(), fn);
+  }
+
+  // Returns true if any interval contains the given point.
+  bool contains(T point) const {
+    const Node* node = Root.get();
+    while (node && point < node->MaxTo) {
+      if (node->Left && point < node->Left->MaxTo) {
+        node = node->Left.get();
+        continue;
+      }
+      if (point < node->From)
+        return false;
+      if (point < node->To)
+        return true;
+      node = node->Right.get();
+    }
+    return false;
+  }
+
+  std::size_t size() const {
+    return Count;
+  }
+
+  bool empty() const {
+    return Count == 0;
+  }
+
+  void swap(IntervalTree<T, V>& other) {
+    Root.swap(other.Root);
+    std::swap(Count, other.Count);
+    std::swap(Seed, other.Seed);
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Intervals are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is always smaller than 'to'
+  // - The tree is a binary search tree on ('from', 'to') and a max-heap on 'Priority'.
+  // - Every node's 'MaxTo' is the largest 'To' in its subtree.
+  NodePtr Root;
+  std::size_t Count = 0;
+  uint32_t Seed = 0x9e3779b9u;
+
+  uint32_t next_priority() {
+    // xorshift32, we just need something cheap that doesn't repeat quickly.
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+  }
+
+  static bool less(const Node* node, T from, T to) {
+    return node->From < from || (node->From == from && node->To < to);
+  }
+
+  static void update(Node* node) {
+    node->MaxTo = node->To;
+    if (node->Left && node->MaxTo < node->Left->MaxTo)
+      node->MaxTo = node->Left->MaxTo;
+    if (node->Right && node->MaxTo < node->Right->MaxTo)
+      node->MaxTo = node->Right->MaxTo;
+  }
+
+  // Splits the tree into the intervals ordered before (from, to) and the rest.
+  static std::pair<NodePtr, NodePtr> split(NodePtr node, T from, T to) {
+    if (!node)
+      return {nullptr, nullptr};
+    if (less(node.get(), from, to)) {
+      auto parts = split(std::move(node->Right), from, to);
+      node->Right = std::move(parts.first);
+      update(node.get());
+      return {std::move(node), std::move(parts.second)};
+    } else {
+      auto parts = split(std::move(node->Left), from, to);
+      node->Left = std::move(parts.second);
+      update(node.get());
+      return {std::move(parts.first), std::move(node)};
+    }
+  }
+
+  // Joins two trees where all intervals in 'left' are ordered before all intervals in 'right'.
+  static NodePtr merge(NodePtr left, NodePtr right) {
+    if (!left)
+      return right;
+    if (!right)
+      return left;
+    if (left->Priority > right->Priority) {
+      left->Right = merge(std::move(left->Right), std::move(right));
+      update(left.get());
+      return left;
+    } else {
+      right->Left = merge(std::move(left), std::move(right->Left));
+      update(right.get());
+      return right;
+    }
+  }
+
+  static bool erase_node(NodePtr& node, T from, T to, const V& value) {
+    if (!node)
+      return false;
+
+    bool erased;
+    if (less(node.get(), from, to)) {
+      erased = erase_node(node->Right, from, to, value);
+    } else if (node->From != from || node->To != to) {
+      erased = erase_node(node->Left, from, to, value);
+    } else if (node->Val == value) {
+      node = merge(std::move(node->Left), std::move(node->Right));
+      return true;
+    } else {
+      // Identical intervals with other values may be on either side.
+      erased = erase_node(node->Left, from, to, value) || erase_node(node->Right, from, to, value);
+    }
+    if (erased)
+      update(node.get());
+    return erased;
+  }
+
+  template <typename F> static void visit_containing(const Node* node, T point, F& fn) {
+    // Nothing in this subtree reaches the point.
+    if (!node || !(point < node->MaxTo))
+      return;
+    visit_containing(node->Left.get(), point, fn);
+    // Everything in the right subtree starts at or after this node, so if this node starts after the point, so do they.
+    if (point < node->From)
+      return;
+    if (point < node->To)
+      fn(node->From, node->To, node->Val);
+    visit_containing(node->Right.get(), point, fn);
+  }
+
+  template <typename F> static void visit_overlapping(const Node* node, T from, T to, F& fn) {
+    if (!node || !(from < node->MaxTo))
+      return;
+    visit_overlapping(node->Left.get(), from, to, fn);
+    if (!(node->From < to))
+      return;
+    if (from < node->To)
+      fn(node->From, node->To, node->Val);
+    visit_overlapping(node->Right.get(), from, to, fn);
+  }
+
+  template <typename F> static void visit_all(const Node* node, F& fn) {
+    if (!node)
+      return;
+    visit_all(node->Left.get(), fn);
+    fn(node->From, node->To, node->Val);
+    visit_all(node->Right.get(), fn);
+  }
+
+  static NodePtr clone(const NodePtr& node) {
+    if (!node)
+      return nullptr;
+    NodePtr copy = std::make_unique<Node>(node->From, node->To, node->Val, node->Priority);
+    copy->MaxTo = node->MaxTo;
+    copy->Left = clone(node->Left);
+    copy->Right = clone(node->Right);
+    return copy;
+  }
+};
+} // namespace HyoutaUtilities
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rangeset.h"
+
+namespace HyoutaUtilities {
+// Immutable copy of a RangeSet that finds ranges with a learned index instead of a plain binary search.
+// The sorted range starts are split into segments in which the position of a start is a linear function of its value,
+// up to a fixed maximum error. A lookup predicts the position from the segment it falls into and then only has to
+// binary search the few entries around that prediction. The segments themselves are indexed the same way, level by
+// level, until a single segment remains.
+// If the starts are close to evenly spread this needs very few segments and beats a full binary search by a lot. For
+// badly distributed starts it degrades to roughly one segment per 'max_error' ranges.
+template <typename T> class LearnedRangeSet {
+private:
+  // Unsigned key type the values are mapped to, such that the order of the values is preserved.
+  template <typename U, bool IsPointer> struct GetKeyType { using K = typename std::make_unsigned<U>::type; };
+  template <typename U> struct GetKeyType<U, true> { using K = std::uintptr_t; };
+  using KeyT = typename GetKeyType<T, std::is_pointer_v<T>>::K;
+
+  struct Entry {
+    T From;
+    T To;
+  };
+
+  struct Segment {
+    // Key of the first entry the segment covers in the level below.
+    KeyT FirstKey;
+
+    // Predicted position of a key is Start + (key - FirstKey) * Slope.
+    double Slope;
+
+    // Index of the first entry the segment covers in the level below. It ends where the next segment starts.
+    std::size_t Start;
+  };
+
+  static constexpr std::size_t NoIndex = ~std::size_t(0);
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return Set->Entries[Index].From;
+    }
+
+    const T& to() const {
+      return Set->Entries[Index].To;
+    }
+
+    const_iterator& operator++() {
+      ++Index;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    const_iterator& operator--() {
+      --Index;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      operator--();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->Index == rhs.Index;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    const LearnedRangeSet* Set;
+    std::size_t Index;
+    const_iterator(const LearnedRangeSet* set, std::size_t index) : Set(set), Index(index) {}
+    friend class LearnedRangeSet;
+  };
+
+  explicit LearnedRangeSet(std::size_t max_error = 32) : MaxError(max_error) {}
+
+  template <typename Observer>
+  explicit LearnedRangeSet(const RangeSet<T, Observer>& rs, std::size_t max_error = 32) : MaxError(max_error) {
+    Entries.reserve(rs.size());
+    for (auto it = rs.begin(); it != rs.end(); ++it)
+      Entries.push_back(Entry{it.from(), it.to()});
+    build_levels();
+  }
+
+  bool contains(T value) const {
+    const std::size_t index = predecessor(value);
+    return index != NoIndex && value < Entries[index].To;
+  }
+
+  // Returns the range that contains the given value, or end() if there is none.
+  const_iterator find(T value) const {
+    const std::size_t index = predecessor(value);
+    if (index != NoIndex && value < Entries[index].To)
+      return const_iterator(this, index);
+    return end();
+  }
+
+  std::size_t size() const {
+    return Entries.size();
+  }
+
+  bool empty() const {
+    return Entries.empty();
+  }
+
+  // Number of segments over all levels of the index.
+  std::size_t segment_count() const {
+    std::size_t count = 0;
+    for (const auto& level : Levels)
+      count += level.size();
+    return count;
+  }
+
+  // Bytes used by the ranges and the index.
+  std::size_t memory_usage() const {
+    return Entries.size() * sizeof(Entry) + segment_count() * sizeof(Segment);
+  }
+
+  void swap(LearnedRangeSet<T>& other) {
+    Entries.swap(other.Entries);
+    Levels.swap(other.Levels);
+    std::swap(MaxError, other.MaxError);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, Entries.size());
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  bool operator==(const LearnedRangeSet<T>& other) const {
+    if (this->Entries.size() != other.Entries.size())
+      return false;
+    for (std::size_t i = 0; i < this->Entries.size(); ++i) {
+      if (this->Entries[i].From != other.Entries[i].From || this->Entries[i].To != other.Entries[i].To)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const LearnedRangeSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    std::size_t free_total = 0;
+    if (begin() == end())
+      return {free_total, 1.0};
+    std::size_t largest_size = 0;
+    for (const Entry& entry : Entries) {
+      const std::size_t size = calc_size(entry.From, entry.To);
+      if (size > largest_size)
+        largest_size = size;
+      free_total += size;
+    }
+    return {free_total, static_cast<double>(free_total - largest_size) / free_total};
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Ranges are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is always smaller than 'to'
+  // - Stored ranges never touch.
+  // - Stored ranges never overlap.
+  // - Entries are sorted.
+  // - Levels[0] indexes Entries, Levels[i] indexes Levels[i - 1], and the last level has exactly one segment.
+  //   Within a segment, every key's predicted position is at most MaxError away from its actual position.
+  std::vector<Entry> Entries;
+  std::vector<std::vector<Segment>> Levels;
+  std::size_t MaxError;
+
+  static KeyT to_key(T value) {
+    if constexpr (std::is_pointer_v<T>) {
+      return reinterpret_cast<KeyT>(value);
+    } else if constexpr (std::is_signed_v<T>) {
+      // Flip the sign bit so negative values order before positive ones.
+      return static_cast<KeyT>(value) ^ (KeyT(1) << (sizeof(KeyT) * 8 - 1));
+    } else {
+      return static_cast<KeyT>(value);
+    }
+  }
+
+  static std::size_t calc_size(T from, T to) {
+    if constexpr (std::is_pointer_v<T>) {
+      // For pointers we don't want pointer arithmetic here, else void* breaks.
+      return reinterpret_cast<std::size_t>(to) - reinterpret_cast<std::size_t>(from);
+    } else {
+      return static_cast<std::size_t>(to - from);
+    }
+  }
+
+  void build_levels() {
+    if (Entries.empty())
+      return;
+    Levels.push_back(fit(Entries.size(), [this](std::size_t i) { return to_key(Entries[i].From); }));
+    while (Levels.back().size() > 1) {
+      const std::vector<Segment>& below = Levels.back();
+      Levels.push_back(fit(below.size(), [&below](std::size_t i) { return below[i].FirstKey; }));
+    }
+  }
+
+  // Splits the strictly increasing keys into as few segments as possible, greedily. For each segment this keeps the
+  // range of slopes that still predict every key seen so far within the error bound, and starts a new segment once
+  // that range becomes empty.
+  template <typename KeyAt> std::vector<Segment> fit(std::size_t count, KeyAt key_at) const {
+    const double error = static_cast<double>(MaxError);
+    std::vector<Segment> segments;
+    std::size_t start = 0;
+    while (start < count) {
+      const KeyT first = key_at(start);
+      double min_slope = 0.0;
+      double max_slope = std::numeric_limits<double>::infinity();
+      std::size_t i = start + 1;
+      for (; i < count; ++i) {
+        const double dx = static_cast<double>(key_at(i) - first);
+        const double dy = static_cast<double>(i - start);
+        const double lo = std::max(min_slope, (dy - error) / dx);
+        const double hi = std::min(max_slope, (dy + error) / dx);
+        if (lo > hi)
+          break;
+        min_slope = lo;
+        max_slope = hi;
+      }
+      const double slope = i == start + 1 ? 0.0 : (min_slope + max_slope) / 2;
+      segments.push_back(Segment{first, slope, start});
+      start = i;
+    }
+    return segments;
+  }
+
+  // Index of the largest key at or before 'key' within the range covered by segments[s], which must contain it.
+  template <typename KeyAt>
+  std::size_t search(const std::vector<Segment>& segments, std::size_t s, std::size_t count, KeyAt key_at,
+                     KeyT key) const {
+    const Segment& segment = segments[s];
+    const std::size_t first = segment.Start;
+    const std::size_t last = (s + 1 < segments.size() ? segments[s + 1].Start : count) - 1;
+
+    // Keys past the last one of the segment would be predicted further out, but they still belong to the last one.
+    const double offset = static_cast<double>(key - segment.FirstKey) * segment.Slope;
+    const std::size_t span = last - first;
+    const std::size_t pos = first + (offset < static_cast<double>(span) ? static_cast<std::size_t>(offset) : span);
+
+    // One extra entry on each side covers the rounding of the prediction.
+    std::size_t lo = pos - first > MaxError + 1 ? pos - MaxError - 1 : first;
+    std::size_t hi = last - pos > MaxError + 1 ? pos + MaxError + 1 : last;
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo + 1) / 2;
+      if (key_at(mid) <= key)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+    return lo;
+  }
+
+  // Index of the range with the largest start at or before 'value', or NoIndex if there is none.
+  std::size_t predecessor(T value) const {
+    const KeyT key = to_key(value);
+    if (Entries.empty() || key < to_key(Entries[0].From))
+      return NoIndex;
+
+    std::size_t s = 0;
+    for (std::size_t level = Levels.size() - 1; level > 0; --level) {
+      const std::vector<Segment>& below = Levels[level - 1];
+      s = search(Levels[level], s, below.size(), [&below](std::size_t i) { return below[i].FirstKey; }, key);
+    }
+    return search(Levels[0], s, Entries.size(), [this](std::size_t i) { return to_key(Entries[i].From); }, key);
+  }
+};
+
+// Creates an immutable copy of the given set that uses a learned index for lookups, see LearnedRangeSet.
+template <typename T, typename Observer>
+LearnedRangeSet<T> freeze_learned(const RangeSet<T, Observer>& rs, std::size_t max_error = 32) {
+  return LearnedRangeSet<T>(rs, max_error);
+}
+} // namespace HyoutaUtilities
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "rangeset.h"
+
+namespace HyoutaUtilities {
+// Observer for RangeSet that keeps a table with one byte per fixed-size page of a window of values, telling whether
+// that page is entirely inside the set, entirely outside of it, or mixed. With that, fast_contains() answers most
+// lookups with a single array load and only has to consult the tree for mixed pages and values outside the window.
+//
+// The table only ever learns about the ranges from the changes reported to it, so a page may stay marked as mixed
+// after it became entirely inside or outside by a sequence of changes that each only touched part of it. That is never
+// wrong, just slower; rebuild() reclassifies every page exactly.
+//
+// RangeSet::split_at() needs a separate, empty table for the returned set, which it fills with the moved ranges.
+template <typename T> class PageLookupTable {
+  static_assert(std::is_integral_v<T> && std::is_unsigned_v<T>, "PageLookupTable needs an unsigned integer type");
+
+public:
+  enum class PageState : uint8_t { Outside, Inside, Mixed };
+
+  PageLookupTable() : Base(0), PageShift(0) {}
+
+  // Covers the values [base, base + (page_count << page_shift)[, which must not wrap around.
+  PageLookupTable(T base, std::size_t page_count, unsigned page_shift)
+      : Base(base), PageShift(page_shift), Pages(page_count, PageState::Outside) {}
+
+  // Classifies the page 'value' is in. Values outside of the window are always mixed.
+  PageState classify(T value) const {
+    // Values below 'Base' wrap around to large offsets, so a single comparison checks both ends of the window.
+    const std::size_t page = static_cast<std::size_t>(static_cast<T>(value - Base) >> PageShift);
+    return page < Pages.size() ? Pages[page] : PageState::Mixed;
+  }
+
+  // Reclassifies every page from the given set, which must be the one this table is attached to.
+  template <typename Set> void rebuild(const Set& rs) {
+    std::fill(Pages.begin(), Pages.end(), PageState::Outside);
+    for (auto it = rs.begin(); it != rs.end(); ++it)
+      mark(it.from(), it.to(), PageState::Inside);
+  }
+
+  T base() const {
+    return Base;
+  }
+
+  std::size_t page_size() const {
+    return std::size_t(1) << PageShift;
+  }
+
+  std::size_t page_count() const {
+    return Pages.size();
+  }
+
+  std::size_t count_mixed() const {
+    return static_cast<std::size_t>(std::count(Pages.begin(), Pages.end(), PageState::Mixed));
+  }
+
+  // Bytes used by the table. This is fixed on construction.
+  std::size_t memory_usage() const {
+    return Pages.size() * sizeof(PageState);
+  }
+
+  void range_added(T from, T to) {
+    mark(from, to, PageState::Inside);
+  }
+
+  void range_removed(T from, T to) {
+    mark(from, to, PageState::Outside);
+  }
+
+  void range_expanded(T from, T /*old_to*/, T new_to) {
+    mark(from, new_to, PageState::Inside);
+  }
+
+  void range_shrunk(T old_from, T old_to, T new_from, T new_to) {
+    mark(old_from, new_from, PageState::Outside);
+    mark(new_to, old_to, PageState::Outside);
+    mark(new_from, new_to, PageState::Inside);
+  }
+
+  void range_split(T from, T to, T hole_from, T hole_to) {
+    mark(hole_from, hole_to, PageState::Outside);
+    mark(from, hole_from, PageState::Inside);
+    mark(hole_to, to, PageState::Inside);
+  }
+
+  void range_merged(T from, T to, T /*absorbed_from*/, T /*absorbed_to*/) {
+    mark(from, to, PageState::Inside);
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - A page marked Inside is entirely contained in a single range of the set.
+  // - A page marked Outside contains no value of the set.
+  T Base;
+  unsigned PageShift;
+  std::vector<PageState> Pages;
+
+  // All of [from, to[ is now 'state' (Inside or Outside). Pages entirely within it take that state, pages it only
+  // partially covers become mixed unless they already had that state.
+  void mark(T from, T to, PageState state) {
+    if (from >= to)
+      return;
+
+    // Work with offsets into the window, clipped to it.
+    const uint64_t window = static_cast<uint64_t>(Pages.size()) << PageShift;
+    const uint64_t lo = from < Base ? 0 : static_cast<uint64_t>(from - Base);
+    const uint64_t hi = std::min(to <= Base ? 0 : static_cast<uint64_t>(to - Base), window);
+    if (lo >= hi)
+      return;
+
+    const std::size_t first = static_cast<std::size_t>(lo >> PageShift);
+    const std::size_t last = static_cast<std::size_t>((hi - 1) >> PageShift);
+    const uint64_t mask = (uint64_t(1) << PageShift) - 1;
+    const bool first_whole = (lo & mask) == 0 && (first < last || (hi & mask) == 0);
+    const bool last_whole = (hi & mask) == 0;
+
+    if (!first_whole && Pages[first] != state)
+      Pages[first] = PageState::Mixed;
+    if (!last_whole && Pages[last] != state)
+      Pages[last] = PageState::Mixed;
+
+    const std::size_t whole_begin = first_whole ? first : first + 1;
+    const std::size_t whole_end = last_whole ? last + 1 : last;
+    if (whole_begin < whole_end)
+      std::fill(Pages.begin() + whole_begin, Pages.begin() + whole_end, state);
+  }
+};
+
+// Looks up 'value' in the page table of the set first and only searches the tree if its page is mixed.
+template <typename T> bool fast_contains(const RangeSet<T, PageLookupTable<T>>& rs, T value) {
+  switch (rs.observer().classify(value)) {
+  case PageLookupTable<T>::PageState::Inside:
+    return true;
+  case PageLookupTable<T>::PageState::Outside:
+    return false;
+  default:
+    return rs.contains(value);
+  }
+}
+} // namespace HyoutaUtilities
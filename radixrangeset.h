@@ -0,0 +1,555 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "bitutils.h"
+
+namespace HyoutaUtilities {
+// Like RangeSet, but stores the ranges in a radix tree indexed by the bits of their start instead of a balanced
+// binary tree, so a lookup costs at most one step per 4 bits of the key regardless of how many ranges there are.
+// Every tree node has 16 slots that each hold either a child node or a single range. A range is stored in the slot of
+// the shallowest node where no other range shares its key prefix, and a node is only created below a slot once two
+// ranges need it, so sparse keys such as addresses scattered over a large address space stay shallow.
+// Works with integers (signed or unsigned) and pointers.
+// Supports the common RangeSet operations, including append and hinted insert and erase, but not the ones that splice
+// the map nodes of two sets together (split_at, join and merge), and takes no observer. As ranges live inside the tree
+// nodes and move between levels when neighbouring ranges come and go, every change invalidates all iterators.
+template <typename T> class RadixRangeSet {
+private:
+  // Unsigned key type the values are mapped to, such that the order of the values is preserved.
+  template <typename U, bool IsPointer> struct GetKeyType { using K = typename std::make_unsigned<U>::type; };
+  template <typename U> struct GetKeyType<U, true> { using K = std::uintptr_t; };
+  using KeyT = typename GetKeyType<T, std::is_pointer_v<T>>::K;
+
+  static constexpr int KeyBits = static_cast<int>(sizeof(KeyT) * 8);
+  static constexpr int BitsPerLevel = 4;
+  static constexpr unsigned Fanout = 1u << BitsPerLevel;
+  static constexpr int RootShift = KeyBits - BitsPerLevel;
+
+  struct Entry {
+    T From;
+    T To;
+  };
+
+  struct Node;
+
+  // A slot holds either a child node or a range, which is stored in place so a range needs no allocation of its own.
+  union Slot {
+    Node* Child;
+    Entry E;
+  };
+
+  struct Node {
+    // Slots that hold a child node or a range, respectively.
+    uint32_t NodeMask = 0;
+    uint32_t LeafMask = 0;
+
+    // Child or E, depending on the masks above. With 64-bit keys a node takes 264 bytes, of which a lookup only reads
+    // the masks and a single slot on its way down.
+    Slot Slots[Fanout] = {};
+  };
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return E->From;
+    }
+
+    const T& to() const {
+      return E->To;
+    }
+
+    const_iterator& operator++() {
+      E = Set->find_after(to_key(E->From));
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    const_iterator& operator--() {
+      E = E ? Set->find_before(to_key(E->From)) : Set->last_entry();
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      operator--();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->E == rhs.E;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    const RadixRangeSet* Set;
+    const Entry* E;
+    const_iterator(const RadixRangeSet* set, const Entry* entry) : Set(set), E(entry) {}
+    friend class RadixRangeSet;
+  };
+
+  RadixRangeSet() = default;
+  // Delegates to the default constructor so that the destructor cleans up if copying the tree fails halfway.
+  RadixRangeSet(const RadixRangeSet<T>& other) : RadixRangeSet() {
+    clone_children(Root, other.Root);
+    Count = other.Count;
+  }
+  RadixRangeSet(RadixRangeSet<T>&& other) {
+    swap(other);
+  }
+  RadixRangeSet<T>& operator=(const RadixRangeSet<T>& other) {
+    if (this != &other) {
+      RadixRangeSet<T> copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+  RadixRangeSet<T>& operator=(RadixRangeSet<T>&& other) {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+  ~RadixRangeSet() {
+    free_children(Root);
+  }
+
+  void insert(T from, T to) {
+    if (from >= to)
+      return;
+    insert_range(from, to);
+  }
+
+  // The radix tree reaches any position in the same few steps, so unlike with RangeSet there is nothing to gain from
+  // appending in order or from hints. These forward to the plain operations, so that RadixRangeSet can stand in for
+  // RangeSet.
+
+  // Returns the range that now contains [from, to[, or end() if the given range was empty.
+  const_iterator append(T from, T to) {
+    if (from >= to)
+      return end();
+    return const_iterator(this, insert_range(from, to));
+  }
+
+  // Returns the range that now contains [from, to[, or 'hint' if nothing was inserted.
+  const_iterator insert(const_iterator hint, T from, T to) {
+    if (from >= to)
+      return hint;
+    return const_iterator(this, insert_range(from, to));
+  }
+
+  // Returns the first range starting at or after 'to', or 'hint' if nothing was erased.
+  const_iterator erase(const_iterator hint, T from, T to) {
+    if (from >= to)
+      return hint;
+    erase(from, to);
+    return lower_bound(to);
+  }
+
+  void erase(T from, T to) {
+    if (from >= to)
+      return;
+
+    // The range starting before 'from' may reach into or beyond the erased range.
+    if (Entry* prev = find_before(to_key(from))) {
+      if (from < prev->To) {
+        const T prevto = prev->To;
+        prev->To = from;
+        if (to < prevto) {
+          insert_entry(to, prevto);
+          return;
+        }
+      }
+    }
+
+    // Ranges starting within the erased range are dropped, but the last one may reach beyond it.
+    const KeyT key = to_key(from);
+    for (const Entry* next = find_at_or_after(key); next && next->From < to; next = find_at_or_after(key)) {
+      const T nextto = next->To;
+      erase_entry(to_key(next->From));
+      if (to < nextto) {
+        insert_entry(to, nextto);
+        return;
+      }
+    }
+  }
+
+  const_iterator erase(const_iterator it) {
+    const KeyT key = to_key(it.from());
+    erase_entry(key);
+    return const_iterator(this, find_after(key));
+  }
+
+  void clear() {
+    free_children(Root);
+    Root = Node();
+    Count = 0;
+  }
+
+  bool contains(T value) const {
+    const Entry* entry = find_at_or_before(to_key(value));
+    return entry && value < entry->To;
+  }
+
+  // Returns the range that contains the given value, or end() if there is none.
+  const_iterator find(T value) const {
+    const Entry* entry = find_at_or_before(to_key(value));
+    if (entry && value < entry->To)
+      return const_iterator(this, entry);
+    return end();
+  }
+
+  // Returns the first range that starts at or after the given value.
+  const_iterator lower_bound(T value) const {
+    return const_iterator(this, find_at_or_after(to_key(value)));
+  }
+
+  // Returns the first range that starts after the given value.
+  const_iterator upper_bound(T value) const {
+    return const_iterator(this, find_after(to_key(value)));
+  }
+
+  std::size_t size() const {
+    return Count;
+  }
+
+  bool empty() const {
+    return Count == 0;
+  }
+
+  void swap(RadixRangeSet<T>& other) {
+    std::swap(Root, other.Root);
+    std::swap(Count, other.Count);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, first_entry());
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, nullptr);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  bool operator==(const RadixRangeSet<T>& other) const {
+    if (this->Count != other.Count)
+      return false;
+    for (auto a = this->begin(), b = other.begin(); a != this->end(); ++a, ++b) {
+      if (a.from() != b.from() || a.to() != b.to())
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const RadixRangeSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    std::size_t free_total = 0;
+    if (begin() == end())
+      return {free_total, 1.0};
+    std::size_t largest_size = 0;
+    for (auto iter = begin(); iter != end(); ++iter) {
+      const std::size_t size = calc_size(iter.from(), iter.to());
+      if (size > largest_size)
+        largest_size = size;
+      free_total += size;
+    }
+    return {free_total, static_cast<double>(free_total - largest_size) / free_total};
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Ranges are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is always smaller than 'to'
+  // - Stored ranges never touch.
+  // - Stored ranges never overlap.
+  // - A range is stored in the node at the depth given by the first 4-bit digit of its key where it differs from all
+  //   other ranges, in the slot for that digit. The path of digits leading to it matches its key.
+  // - Nodes other than the root hold at least two ranges in their subtree.
+  Node Root;
+  std::size_t Count = 0;
+
+  static KeyT to_key(T value) {
+    if constexpr (std::is_pointer_v<T>) {
+      return reinterpret_cast<KeyT>(value);
+    } else if constexpr (std::is_signed_v<T>) {
+      // Flip the sign bit so negative values order before positive ones.
+      return static_cast<KeyT>(value) ^ (KeyT(1) << (KeyBits - 1));
+    } else {
+      return static_cast<KeyT>(value);
+    }
+  }
+
+  static std::size_t calc_size(T from, T to) {
+    if constexpr (std::is_pointer_v<T>) {
+      // For pointers we don't want pointer arithmetic here, else void* breaks.
+      return reinterpret_cast<std::size_t>(to) - reinterpret_cast<std::size_t>(from);
+    } else {
+      return static_cast<std::size_t>(to - from);
+    }
+  }
+
+  static unsigned digit(KeyT key, int shift) {
+    return static_cast<unsigned>(key >> shift) & (Fanout - 1);
+  }
+
+  static unsigned lowest_slot(uint32_t mask) {
+    return static_cast<unsigned>(BitUtils::count_trailing_zeros(mask));
+  }
+
+  static unsigned highest_slot(uint32_t mask) {
+    return static_cast<unsigned>(63 - BitUtils::count_leading_zeros(mask));
+  }
+
+  // The lookups below are templates over 'Node' and 'const Node', so they hand out ranges that can be changed exactly
+  // when the set can be.
+
+  // Leftmost range in the subtree starting at the given slot.
+  template <typename NodeT> static auto* min_entry(NodeT* node, unsigned slot) {
+    while (!(node->LeafMask & (1u << slot))) {
+      node = node->Slots[slot].Child;
+      slot = lowest_slot(node->NodeMask | node->LeafMask);
+    }
+    return &node->Slots[slot].E;
+  }
+
+  // Rightmost range in the subtree starting at the given slot.
+  template <typename NodeT> static auto* max_entry(NodeT* node, unsigned slot) {
+    while (!(node->LeafMask & (1u << slot))) {
+      node = node->Slots[slot].Child;
+      slot = highest_slot(node->NodeMask | node->LeafMask);
+    }
+    return &node->Slots[slot].E;
+  }
+
+  const Entry* first_entry() const {
+    const uint32_t mask = Root.NodeMask | Root.LeafMask;
+    return mask ? min_entry(&Root, lowest_slot(mask)) : nullptr;
+  }
+
+  const Entry* last_entry() const {
+    const uint32_t mask = Root.NodeMask | Root.LeafMask;
+    return mask ? max_entry(&Root, highest_slot(mask)) : nullptr;
+  }
+
+  // Range with the largest start at or before 'key' in the subtree of 'node', or nullptr if there is none.
+  template <typename NodeT>
+  static auto find_at_or_before(NodeT* node, int shift, KeyT key) -> decltype(&node->Slots[0].E) {
+    const unsigned d = digit(key, shift);
+    const uint32_t bit = 1u << d;
+    if (node->LeafMask & bit) {
+      auto* entry = &node->Slots[d].E;
+      if (to_key(entry->From) <= key)
+        return entry;
+    } else if (node->NodeMask & bit) {
+      NodeT* child = node->Slots[d].Child;
+      if (auto* entry = find_at_or_before(child, shift - BitsPerLevel, key))
+        return entry;
+    }
+    const uint32_t below = (node->NodeMask | node->LeafMask) & (bit - 1);
+    return below ? max_entry(node, highest_slot(below)) : nullptr;
+  }
+
+  // Range with the smallest start at or after 'key' in the subtree of 'node', or nullptr if there is none.
+  static const Entry* find_at_or_after(const Node* node, int shift, KeyT key) {
+    const unsigned d = digit(key, shift);
+    const uint32_t bit = 1u << d;
+    if (node->LeafMask & bit) {
+      const Entry* entry = &node->Slots[d].E;
+      if (key <= to_key(entry->From))
+        return entry;
+    } else if (node->NodeMask & bit) {
+      if (const Entry* entry = find_at_or_after(node->Slots[d].Child, shift - BitsPerLevel, key))
+        return entry;
+    }
+    const uint32_t above = (node->NodeMask | node->LeafMask) & ~((bit << 1) - 1);
+    return above ? min_entry(node, lowest_slot(above)) : nullptr;
+  }
+
+  const Entry* find_at_or_before(KeyT key) const {
+    return find_at_or_before(&Root, RootShift, key);
+  }
+
+  Entry* find_at_or_before(KeyT key) {
+    return find_at_or_before(&Root, RootShift, key);
+  }
+
+  const Entry* find_at_or_after(KeyT key) const {
+    return find_at_or_after(&Root, RootShift, key);
+  }
+
+  const Entry* find_before(KeyT key) const {
+    return key == 0 ? nullptr : find_at_or_before(key - 1);
+  }
+
+  Entry* find_before(KeyT key) {
+    return key == 0 ? nullptr : find_at_or_before(key - 1);
+  }
+
+  const Entry* find_after(KeyT key) const {
+    return key == static_cast<KeyT>(~KeyT(0)) ? nullptr : find_at_or_after(key + 1);
+  }
+
+  // Inserts [from, to[, which must not be empty. Returns the range that now contains it.
+  const Entry* insert_range(T from, T to) {
+    // Start from the range that reaches 'from', if there is one...
+    if (const Entry* prev = find_at_or_before(to_key(from))) {
+      if (!(prev->To < from)) {
+        if (!(prev->To < to))
+          return prev;
+        from = prev->From;
+      }
+    }
+
+    // ...and absorb all following ranges that the new one overlaps or touches.
+    const KeyT key = to_key(from);
+    for (const Entry* next = find_after(key); next && !(to < next->From); next = find_after(key)) {
+      if (to < next->To)
+        to = next->To;
+      erase_entry(to_key(next->From));
+    }
+
+    // Erasing may have moved the range at 'from' to another level, so only look it up now.
+    Entry* target = find_at_or_before(key);
+    if (target && target->From == from) {
+      target->To = to;
+      return target;
+    }
+    return insert_entry(from, to);
+  }
+
+  // Adds a new range, whose start must not be stored yet. Returns where it was stored.
+  Entry* insert_entry(T from, T to) {
+    const KeyT key = to_key(from);
+    Node* node = &Root;
+    int shift = RootShift;
+    unsigned d = digit(key, shift);
+    while (node->NodeMask & (1u << d)) {
+      node = node->Slots[d].Child;
+      shift -= BitsPerLevel;
+      d = digit(key, shift);
+    }
+    const uint32_t bit = 1u << d;
+    if (!(node->LeafMask & bit)) {
+      node->Slots[d].E = Entry{from, to};
+      node->LeafMask |= bit;
+      ++Count;
+      return &node->Slots[d].E;
+    }
+
+    // The slot is taken by another range. Both go into a new node at the first digit where their keys differ, below a
+    // chain of nodes for the digits they share. All nodes are allocated before any is linked in, so the set stays
+    // unchanged if an allocation fails.
+    const Entry other = node->Slots[d].E;
+    const KeyT otherkey = to_key(other.From);
+    assert(otherkey != key);
+    const int highest = 63 - BitUtils::count_leading_zeros(static_cast<uint64_t>(key ^ otherkey));
+    const int bottom = highest - highest % BitsPerLevel;
+    const int depth = (shift - bottom) / BitsPerLevel;
+    std::unique_ptr<Node> chain[KeyBits / BitsPerLevel];
+    for (int i = 0; i < depth; ++i)
+      chain[i] = std::make_unique<Node>();
+
+    for (int i = 0; i + 1 < depth; ++i) {
+      const unsigned cd = digit(key, shift - BitsPerLevel * (i + 1));
+      chain[i]->Slots[cd].Child = chain[i + 1].get();
+      chain[i]->NodeMask = 1u << cd;
+    }
+    Node* last = chain[depth - 1].get();
+    const unsigned od = digit(otherkey, bottom);
+    const unsigned nd = digit(key, bottom);
+    last->Slots[od].E = other;
+    last->Slots[nd].E = Entry{from, to};
+    last->LeafMask = (1u << od) | (1u << nd);
+
+    node->Slots[d].Child = chain[0].get();
+    node->LeafMask &= ~bit;
+    node->NodeMask |= bit;
+    for (int i = 0; i < depth; ++i)
+      chain[i].release();
+    ++Count;
+    return &last->Slots[nd].E;
+  }
+
+  // Removes the range with the given start, which must be stored.
+  void erase_entry(KeyT key) {
+    remove_entry(&Root, RootShift, key);
+    --Count;
+  }
+
+  static void remove_entry(Node* node, int shift, KeyT key) {
+    const unsigned d = digit(key, shift);
+    const uint32_t bit = 1u << d;
+    if (node->LeafMask & bit) {
+      assert(to_key(node->Slots[d].E.From) == key);
+      node->Slots[d].Child = nullptr;
+      node->LeafMask &= ~bit;
+      return;
+    }
+
+    assert(node->NodeMask & bit);
+    Node* child = node->Slots[d].Child;
+    remove_entry(child, shift - BitsPerLevel, key);
+
+    // If the child is left with a single range, that range no longer needs the extra level, so pull it up.
+    if (child->NodeMask == 0 && BitUtils::popcount(child->LeafMask) == 1) {
+      node->Slots[d].E = child->Slots[lowest_slot(child->LeafMask)].E;
+      node->NodeMask &= ~bit;
+      node->LeafMask |= bit;
+      delete child;
+    }
+  }
+
+  static void free_children(Node& node) {
+    for (unsigned slot = 0; slot < Fanout; ++slot) {
+      if (node.NodeMask & (1u << slot)) {
+        Node* child = node.Slots[slot].Child;
+        free_children(*child);
+        delete child;
+      }
+    }
+  }
+
+  // Every node is linked in before it is filled, so a partial copy can still be freed if an allocation fails.
+  static void clone_children(Node& target, const Node& source) {
+    target.LeafMask = source.LeafMask;
+    for (unsigned slot = 0; slot < Fanout; ++slot) {
+      const uint32_t bit = 1u << slot;
+      if (source.LeafMask & bit) {
+        target.Slots[slot].E = source.Slots[slot].E;
+      } else if (source.NodeMask & bit) {
+        Node* child = new Node();
+        target.Slots[slot].Child = child;
+        target.NodeMask |= bit;
+        clone_children(*child, *source.Slots[slot].Child);
+      }
+    }
+  }
+};
+} // namespace HyoutaUtilities
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <utility>
+
+#include "rangeset.h"
+
+namespace HyoutaUtilities {
+// Like RangeSet, but instead of merging overlapping ranges, counts how often each value is covered.
+// The covered area is stored as a list of segments with a coverage count each. Segments are split when a range is added
+// or removed across their edges, and touching segments with equal counts are merged back together, so each stored
+// segment is a maximal run of one count.
+template <typename T> class RangeCountSet {
+private:
+  // Value type stored in the map.
+  struct Value {
+    // End point of the segment.
+    T To;
+
+    // Number of ranges covering this segment.
+    std::size_t Count;
+
+    Value(T to, std::size_t count) : To(to), Count(count) {}
+
+    bool operator==(const Value& other) const {
+      return this->To == other.To && this->Count == other.Count;
+    }
+
+    bool operator!=(const Value& other) const {
+      return !operator==(other);
+    }
+  };
+
+  using MapT = std::map<T, Value>;
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return It->first;
+    }
+
+    const T& to() const {
+      return It->second.To;
+    }
+
+    std::size_t count() const {
+      return It->second.Count;
+    }
+
+    const_iterator& operator++() {
+      ++It;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++It;
+      return old;
+    }
+
+    const_iterator& operator--() {
+      --It;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      --It;
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->It == rhs.It;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    typename MapT::const_iterator It;
+    const_iterator(typename MapT::const_iterator it) : It(it) {}
+    friend class RangeCountSet;
+  };
+
+  // Increments the coverage count of [from, to[ by one.
+  void add(T from, T to) {
+    if (from >= to)
+      return;
+
+    split_at(from);
+    split_at(to);
+
+    // Walk all segments within the range, incrementing the existing ones and filling the gaps between them.
+    auto it = Map.lower_bound(from);
+    T cursor = from;
+    while (cursor < to) {
+      if (it == Map.end() || get_from(it) > cursor) {
+        const T gap_to = (it == Map.end() || get_from(it) >= to) ? to : get_from(it);
+        Map.emplace_hint(it, cursor, Value(gap_to, 1));
+        cursor = gap_to;
+      } else {
+        ++it->second.Count;
+        cursor = get_to(it);
+        ++it;
+      }
+    }
+
+    coalesce(from, to);
+  }
+
+  // Decrements the coverage count of [from, to[ by one. Parts of the range that aren't covered are ignored.
+  void remove(T from, T to) {
+    remove(from, to, [](T, T) {});
+  }
+
+  // Like remove(T, T), but calls 'on_zero(from, to)' for every segment whose coverage dropped to zero.
+  // The callback must not modify this set.
+  template <typename F> void remove(T from, T to, F&& on_zero) {
+    if (from >= to)
+      return;
+
+    split_at(from);
+    split_at(to);
+
+    auto it = Map.lower_bound(from);
+    while (it != Map.end() && get_from(it) < to) {
+      assert(it->second.Count > 0);
+      if (--it->second.Count == 0) {
+        const T zero_from = get_from(it);
+        const T zero_to = get_to(it);
+        it = Map.erase(it);
+        on_zero(zero_from, zero_to);
+      } else {
+        ++it;
+      }
+    }
+
+    coalesce(from, to);
+  }
+
+  void clear() {
+    Map.clear();
+  }
+
+  // Returns how many ranges cover the given value.
+  std::size_t count_at(T value) const {
+    auto it = Map.upper_bound(value);
+    if (it == Map.begin())
+      return 0;
+    --it;
+    return value < get_to(it) ? it->second.Count : 0;
+  }
+
+  bool contains(T value) const {
+    return count_at(value) > 0;
+  }
+
+  // Returns all ranges that are covered at least 'count' times.
+  RangeSet<T> ranges_at_least(std::size_t count) const {
+    RangeSet<T> result;
+    for (auto it = Map.begin(); it != Map.end(); ++it) {
+      if (it->second.Count >= count)
+        result.insert(get_from(it), get_to(it));
+    }
+    return result;
+  }
+
+  // Number of stored segments.
+  std::size_t size() const {
+    return Map.size();
+  }
+
+  bool empty() const {
+    return Map.empty();
+  }
+
+  void swap(RangeCountSet<T>& other) {
+    Map.swap(other.Map);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(Map.begin());
+  }
+
+  const_iterator end() const {
+    return const_iterator(Map.end());
+  }
+
+  const_iterator cbegin() const {
+    return const_iterator(Map.cbegin());
+  }
+
+  const_iterator cend() const {
+    return const_iterator(Map.cend());
+  }
+
+  bool operator==(const RangeCountSet<T>& other) const {
+    return this->Map == other.Map;
+  }
+
+  bool operator!=(const RangeCountSet<T>& other) const {
+    return !(*this == other);
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Segments are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is the map key, 'to' and the count are the map value
+  // - 'from' is always smaller than 'to'
+  // - The count is never zero, uncovered areas are not stored.
+  // - Stored segments never overlap.
+  // - Stored segments only touch if their counts differ.
+  MapT Map;
+
+  T get_from(typename MapT::iterator it) const {
+    return it->first;
+  }
+
+  T get_to(typename MapT::iterator it) const {
+    return it->second.To;
+  }
+
+  T get_from(typename MapT::const_iterator it) const {
+    return it->first;
+  }
+
+  T get_to(typename MapT::const_iterator it) const {
+    return it->second.To;
+  }
+
+  // If a segment strictly contains the given value, split it into two segments at that value.
+  void split_at(T value) {
+    auto it = Map.upper_bound(value);
+    if (it == Map.begin())
+      return;
+    auto prev = std::prev(it);
+    if (get_from(prev) < value && value < get_to(prev)) {
+      Map.emplace_hint(it, value, Value(get_to(prev), prev->second.Count));
+      prev->second.To = value;
+    }
+  }
+
+  // Merges touching segments with equal counts, from the segment before 'from' up to the segment starting at 'to'.
+  void coalesce(T from, T to) {
+    auto it = Map.lower_bound(from);
+    if (it != Map.begin())
+      --it;
+    while (it != Map.end()) {
+      auto next = std::next(it);
+      if (next == Map.end() || get_from(next) > to)
+        return;
+      if (get_to(it) == get_from(next) && it->second.Count == next->second.Count) {
+        it->second.To = get_to(next);
+        Map.erase(next);
+      } else {
+        it = next;
+      }
+    }
+  }
+};
+} // namespace HyoutaUtilities
@@ -0,0 +1,109 @@
+#pragma once
+
+namespace HyoutaUtilities {
+// The logic for erasing a span of values, shared by RangeSet and RangeMap.
+// Both store their ranges in a std::map keyed by the start of each range, and provide the same private primitives for
+// changing a single range (get_from, get_to, erase_range, reduce_from, reduce_to, bisect_range), which this calls so
+// that each container can do its own bookkeeping on top. They befriend this struct so it can reach them.
+struct RangeEraser {
+  // Erases [from, to[ from 'set', where 'bound' is the first range in 'map' that starts after 'from'. Returns the first
+  // range starting at or after 'to'.
+  template <typename Set, typename MapT, typename T>
+  static typename MapT::iterator erase_before(Set& set, MapT& map, typename MapT::iterator bound, T from, T to) {
+    if (bound == map.end()) {
+      // There is no range that starts greater than the given one.
+      if (map.empty()) {
+        // nothing to do
+        return map.end();
+      }
+      --bound;
+      // 'bound' now points at the last range.
+      if (from >= set.get_to(bound)) {
+        // Given range is larger than any range that exists, nothing to do.
+        return map.end();
+      }
+
+      if (to >= set.get_to(bound)) {
+        if (from == set.get_from(bound)) {
+          // Given range fully overlaps last range, erase it.
+          return set.erase_range(bound);
+        } else {
+          // Given range overlaps end of last range, reduce it.
+          set.reduce_to(bound, from);
+          return map.end();
+        }
+      }
+
+      if (from == set.get_from(bound)) {
+        // Given range overlaps begin of last range, reduce it.
+        return set.reduce_from(bound, to);
+      } else {
+        // Given range overlaps middle of last range, bisect it.
+        return set.bisect_range(bound, from, to);
+      }
+    }
+
+    if (bound == map.begin()) {
+      // If we found the first range that means 'from' is before any stored range.
+      // This means we can just erase from start until 'to' and be done with it.
+      return erase_from_iterator_to_value(set, map, bound, to);
+    }
+
+    // check previous range
+    auto abound = bound--;
+
+    if (from == set.get_from(bound)) {
+      // Similarly, if the previous range starts with the given one, just erase until 'to'.
+      return erase_from_iterator_to_value(set, map, bound, to);
+    }
+
+    // If we come here, the given range may or may not overlap part of the current 'bound'
+    // (but never the full range), which means we may need to update the end position of it,
+    // or possibly even split it into two.
+    if (from < set.get_to(bound)) {
+      if (to < set.get_to(bound)) {
+        // need to split in two
+        return set.bisect_range(bound, from, to);
+      } else {
+        // just update end
+        set.reduce_to(bound, from);
+      }
+    }
+
+    // and then just erase until 'to'
+    return erase_from_iterator_to_value(set, map, abound, to);
+  }
+
+  // Erases everything before 'to', starting at 'bound', which must start at or after the 'from' value of the span to
+  // erase. Returns the first range starting at or after 'to'.
+  template <typename Set, typename MapT, typename T>
+  static typename MapT::iterator erase_from_iterator_to_value(Set& set, MapT& map, typename MapT::iterator bound,
+                                                              T to) {
+    while (true) {
+      // Given range starts before stored range.
+      if (to <= set.get_from(bound)) {
+        // Range ends before this range too, nothing to do.
+        return bound;
+      }
+
+      if (to < set.get_to(bound)) {
+        // Range ends in the middle of current range, reduce current.
+        return set.reduce_from(bound, to);
+      }
+
+      if (to == set.get_to(bound)) {
+        // Range ends exactly with current range, erase current.
+        return set.erase_range(bound);
+      }
+
+      // Range ends later than current range.
+      // First erase current, then loop to check the range(s) after this one too.
+      bound = set.erase_range(bound);
+      if (bound == map.end()) {
+        // Unless that was the last range, in which case there's nothing else to do.
+        return bound;
+      }
+    }
+  }
+};
+} // namespace HyoutaUtilities
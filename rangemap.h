@@ -0,0 +1,265 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "rangeerase.h"
+
+namespace HyoutaUtilities {
+// Like RangeSet, but associates a value with each range.
+// Assigning a value to a range overwrites the values of all overlapping ranges, splitting them where necessary.
+// Touching ranges are only merged if their values compare equal, so each stored range is a maximal run of one value.
+template <typename K, typename V> class RangeMap {
+private:
+  // Value type stored in the map.
+  struct Value {
+    // End point of the range.
+    K To;
+
+    // Value associated with the range.
+    V Val;
+
+    Value(K to, const V& val) : To(to), Val(val) {}
+    Value(K to, V&& val) : To(to), Val(std::move(val)) {}
+
+    bool operator==(const Value& other) const {
+      return this->To == other.To && this->Val == other.Val;
+    }
+
+    bool operator!=(const Value& other) const {
+      return !operator==(other);
+    }
+  };
+
+  using MapT = std::map<K, Value>;
+
+public:
+  struct const_iterator {
+  public:
+    const K& from() const {
+      return It->first;
+    }
+
+    const K& to() const {
+      return It->second.To;
+    }
+
+    const V& value() const {
+      return It->second.Val;
+    }
+
+    const_iterator& operator++() {
+      ++It;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++It;
+      return old;
+    }
+
+    const_iterator& operator--() {
+      --It;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      --It;
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->It == rhs.It;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    typename MapT::const_iterator It;
+    const_iterator(typename MapT::const_iterator it) : It(it) {}
+    friend class RangeMap;
+  };
+
+  // Associates [from, to[ with the given value, overwriting whatever was there before.
+  // The value is taken by value, so it may refer to a value stored in this map, even one that gets overwritten.
+  void assign(K from, K to, V value) {
+    if (from >= to)
+      return;
+
+    // First clear out the given range, splitting ranges that overlap its edges.
+    erase(from, to);
+    auto inserted = insert_range(from, to, std::move(value));
+
+    // Then coalesce with the neighboring ranges if they touch and hold the same value.
+    if (inserted != Map.begin()) {
+      auto prev = std::prev(inserted);
+      if (get_to(prev) == from && prev->second.Val == inserted->second.Val) {
+        expand_to(prev, to);
+        erase_range(inserted);
+        inserted = prev;
+      }
+    }
+    auto next = std::next(inserted);
+    if (next != Map.end() && get_from(next) == to && next->second.Val == inserted->second.Val) {
+      expand_to(inserted, get_to(next));
+      erase_range(next);
+    }
+  }
+
+  // Removes all associations in [from, to[.
+  void erase(K from, K to) {
+    if (from >= to)
+      return;
+
+    RangeEraser::erase_before(*this, Map, Map.upper_bound(from), from, to);
+  }
+
+  const_iterator erase(const_iterator it) {
+    return const_iterator(erase_range(it.It));
+  }
+
+  void clear() {
+    Map.clear();
+  }
+
+  bool contains(K key) const {
+    return find(key) != end();
+  }
+
+  // Returns the range that contains the given key, or end() if there is none.
+  const_iterator find(K key) const {
+    auto it = Map.upper_bound(key);
+    if (it == Map.begin())
+      return end();
+    --it;
+    if (key < get_to(it))
+      return const_iterator(it);
+    return end();
+  }
+
+  // Returns the value associated with the given key. Like std::map::at(), throws std::out_of_range if there is none.
+  const V& at(K key) const {
+    auto it = find(key);
+    if (it == end())
+      throw std::out_of_range("RangeMap::at");
+    return it.value();
+  }
+
+  std::size_t size() const {
+    return Map.size();
+  }
+
+  bool empty() const {
+    return Map.empty();
+  }
+
+  void swap(RangeMap<K, V>& other) {
+    Map.swap(other.Map);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(Map.begin());
+  }
+
+  const_iterator end() const {
+    return const_iterator(Map.end());
+  }
+
+  const_iterator cbegin() const {
+    return const_iterator(Map.cbegin());
+  }
+
+  const_iterator cend() const {
+    return const_iterator(Map.cend());
+  }
+
+  bool operator==(const RangeMap<K, V>& other) const {
+    return this->Map == other.Map;
+  }
+
+  bool operator!=(const RangeMap<K, V>& other) const {
+    return !(*this == other);
+  }
+
+private:
+  // Shares the logic for erasing spans with RangeSet.
+  friend struct RangeEraser;
+
+  // Assumptions that can be made about the data:
+  // - Range are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is the map key, 'to' and the associated value are the map value
+  // - 'from' is always smaller than 'to'
+  // - Stored ranges never overlap.
+  // - Stored ranges only touch if their values differ.
+  MapT Map;
+
+  K get_from(typename MapT::iterator it) const {
+    return it->first;
+  }
+
+  K get_to(typename MapT::iterator it) const {
+    return it->second.To;
+  }
+
+  K get_from(typename MapT::const_iterator it) const {
+    return it->first;
+  }
+
+  K get_to(typename MapT::const_iterator it) const {
+    return it->second.To;
+  }
+
+  template <typename U> typename MapT::iterator insert_range(K from, K to, U&& value) {
+    return Map.emplace(std::piecewise_construct, std::forward_as_tuple(from),
+                       std::forward_as_tuple(to, std::forward<U>(value)))
+        .first;
+  }
+
+  typename MapT::iterator erase_range(typename MapT::iterator it) {
+    return Map.erase(it);
+  }
+
+  typename MapT::const_iterator erase_range(typename MapT::const_iterator it) {
+    return Map.erase(it);
+  }
+
+  typename MapT::iterator bisect_range(typename MapT::iterator it, K from, K to) {
+    assert(get_from(it) < from);
+    assert(get_from(it) < to);
+    assert(get_to(it) > from);
+    assert(get_to(it) > to);
+    assert(from < to);
+    K itto = get_to(it);
+    reduce_to(it, from);
+    return insert_range(to, itto, it->second.Val);
+  }
+
+  typename MapT::iterator reduce_from(typename MapT::iterator it, K from) {
+    assert(get_from(it) < from);
+    K itto = get_to(it);
+    V val = std::move(it->second.Val);
+    erase_range(it);
+    return insert_range(from, itto, std::move(val));
+  }
+
+  void expand_to(typename MapT::iterator it, K to) {
+    assert(get_to(it) < to);
+    it->second.To = to;
+  }
+
+  void reduce_to(typename MapT::iterator it, K to) {
+    assert(get_to(it) > to);
+    it->second.To = to;
+  }
+};
+} // namespace HyoutaUtilities
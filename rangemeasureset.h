@@ -0,0 +1,606 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace HyoutaUtilities {
+// Like RangeSet, but every node of the underlying tree also knows the total size, number and largest size of the
+// ranges in its subtree. This allows asking how much of a window is covered, how many ranges overlap it and what the
+// largest (clipped) range within it is in O(log n), instead of walking all ranges within the window.
+// Ranges are stored in a treap ordered by their start.
+template <typename T> class RangeMeasureSet {
+private:
+  struct Node {
+    // Range stored in this node, in the form [From, To[.
+    T From;
+    T To;
+
+    // Total size, number and largest size of the ranges in this subtree.
+    std::size_t Sum;
+    std::size_t Count;
+    std::size_t MaxSize;
+
+    // Random heap priority that keeps the tree balanced.
+    uint32_t Priority;
+
+    std::unique_ptr<Node> Left;
+    std::unique_ptr<Node> Right;
+
+    // Node this is a child of. Only valid if this is not the root, see update().
+    const Node* Parent = nullptr;
+
+    Node(T from, T to, uint32_t priority)
+        : From(from), To(to), Sum(calc_size(from, to)), Count(1), MaxSize(Sum), Priority(priority) {}
+  };
+
+  using NodePtr = std::unique_ptr<Node>;
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return N->From;
+    }
+
+    const T& to() const {
+      return N->To;
+    }
+
+    const_iterator& operator++() {
+      if (N->Right) {
+        N = first(N->Right.get());
+        return *this;
+      }
+      // Walk up until we come from a left child, its parent is the next range.
+      const Node* node = N;
+      while (node != Set->Root.get()) {
+        const Node* parent = node->Parent;
+        if (parent->Left.get() == node) {
+          N = parent;
+          return *this;
+        }
+        node = parent;
+      }
+      N = nullptr;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    const_iterator& operator--() {
+      if (!N) {
+        N = last(Set->Root.get());
+        return *this;
+      }
+      if (N->Left) {
+        N = last(N->Left.get());
+        return *this;
+      }
+      // Walk up until we come from a right child, its parent is the previous range.
+      const Node* node = N;
+      while (node != Set->Root.get()) {
+        const Node* parent = node->Parent;
+        if (parent->Right.get() == node) {
+          N = parent;
+          return *this;
+        }
+        node = parent;
+      }
+      N = nullptr;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      operator--();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->N == rhs.N;
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    const RangeMeasureSet* Set;
+    const Node* N;
+    const_iterator(const RangeMeasureSet* set, const Node* node) : Set(set), N(node) {}
+    friend class RangeMeasureSet;
+  };
+
+  RangeMeasureSet() = default;
+  RangeMeasureSet(const RangeMeasureSet<T>& other) : Root(clone(other.Root)), Seed(other.Seed) {}
+  RangeMeasureSet(RangeMeasureSet<T>&&) = default;
+  RangeMeasureSet<T>& operator=(const RangeMeasureSet<T>& other) {
+    if (this != &other) {
+      Root = clone(other.Root);
+      Seed = other.Seed;
+    }
+    return *this;
+  }
+  RangeMeasureSet<T>& operator=(RangeMeasureSet<T>&&) = default;
+
+  void insert(T from, T to) {
+    if (from >= to)
+      return;
+
+    // Absorb the range before 'from' if it reaches 'from'...
+    auto parts = split(std::move(Root), from);
+    NodePtr left = std::move(parts.first);
+    if (left && !(last(left.get())->To < from)) {
+      NodePtr prev = pop_last(left);
+      from = prev->From;
+      if (to < prev->To)
+        to = prev->To;
+    }
+
+    // ...and all ranges that start within [from, to].
+    auto rest = split_after(std::move(parts.second), to);
+    if (rest.first) {
+      const T covered_to = last(rest.first.get())->To;
+      if (to < covered_to)
+        to = covered_to;
+    }
+
+    NodePtr node = std::make_unique<Node>(from, to, next_priority());
+    Root = merge(merge(std::move(left), std::move(node)), std::move(rest.second));
+  }
+
+  void erase(T from, T to) {
+    if (from >= to)
+      return;
+
+    auto parts = split(std::move(Root), from);
+    NodePtr left = std::move(parts.first);
+    auto rest = split(std::move(parts.second), to);
+    NodePtr right = std::move(rest.second);
+
+    // The range before 'from' may reach into or beyond the erased range.
+    if (left && from < last(left.get())->To) {
+      NodePtr prev = pop_last(left);
+      left = merge(std::move(left), std::make_unique<Node>(prev->From, from, next_priority()));
+      if (to < prev->To)
+        right = merge(std::make_unique<Node>(to, prev->To, next_priority()), std::move(right));
+    }
+
+    // Ranges starting within the erased range are dropped, but the last one may reach beyond it.
+    if (rest.first && to < last(rest.first.get())->To)
+      right = merge(std::make_unique<Node>(to, last(rest.first.get())->To, next_priority()), std::move(right));
+
+    Root = merge(std::move(left), std::move(right));
+  }
+
+  void clear() {
+    Root.reset();
+  }
+
+  // Moves all values at or after 'key' into the returned set, splitting a range that reaches across 'key'. O(log n).
+  RangeMeasureSet<T> split_at(T key) {
+    auto parts = split(std::move(Root), key);
+    NodePtr left = std::move(parts.first);
+    NodePtr right = std::move(parts.second);
+    if (left && key < last(left.get())->To) {
+      NodePtr straddling = pop_last(left);
+      left = merge(std::move(left), std::make_unique<Node>(straddling->From, key, next_priority()));
+      right = merge(std::make_unique<Node>(key, straddling->To, next_priority()), std::move(right));
+    }
+
+    Root = std::move(left);
+    RangeMeasureSet<T> result;
+    result.Root = std::move(right);
+    result.Seed = next_priority();
+    return result;
+  }
+
+  // Moves all ranges of 'other' into this set. Either all ranges of 'other' must lie after all ranges of this set, or
+  // the other way around; ranges touching at the seam are merged. O(log n).
+  void join(RangeMeasureSet<T>&& other) {
+    if (!other.Root)
+      return;
+    if (!Root) {
+      Root = std::move(other.Root);
+      return;
+    }
+
+    NodePtr left = std::move(Root);
+    NodePtr right = std::move(other.Root);
+    if (first(left.get())->From > last(right.get())->From)
+      left.swap(right);
+    assert(last(left.get())->To <= first(right.get())->From);
+
+    if (last(left.get())->To == first(right.get())->From) {
+      NodePtr lower = pop_last(left);
+      NodePtr upper = pop_first(right);
+      left = merge(std::move(left), std::make_unique<Node>(lower->From, upper->To, next_priority()));
+    }
+    Root = merge(std::move(left), std::move(right));
+  }
+
+  bool contains(T value) const {
+    return find_node(value) != nullptr;
+  }
+
+  // Returns the range that contains the given value, or end() if there is none.
+  const_iterator find(T value) const {
+    return const_iterator(this, find_node(value));
+  }
+
+  // Number of values in [lo, hi[ that are in the set.
+  std::size_t covered_size(T lo, T hi) const {
+    if (!(lo < hi))
+      return 0;
+    return covered_before(hi) - covered_before(lo);
+  }
+
+  // Number of values in the set.
+  std::size_t covered_size() const {
+    return Root ? Root->Sum : 0;
+  }
+
+  // Number of ranges that overlap [lo, hi[.
+  std::size_t count_ranges(T lo, T hi) const {
+    if (!(lo < hi))
+      return 0;
+    return count_starting_before(hi) - count_ending_at_or_before(lo);
+  }
+
+  // Size of the largest range that overlaps [lo, hi[, counting only the part within [lo, hi[.
+  std::size_t largest_in(T lo, T hi) const {
+    if (!(lo < hi))
+      return 0;
+
+    // The ranges reaching over either edge of the window are clipped, everything in between is taken as-is.
+    std::size_t largest = max_within(Root.get(), lo, hi);
+    if (const Node* node = find_node(lo))
+      largest = max_size(largest, calc_size(lo, node->To < hi ? node->To : hi));
+    if (const Node* node = find_last_starting_before(hi)) {
+      if (lo < node->To)
+        largest = max_size(largest, calc_size(lo < node->From ? node->From : lo, node->To < hi ? node->To : hi));
+    }
+    return largest;
+  }
+
+  // Calls fn(from, to) for every range, in order.
+  template <typename F> void for_each(F&& fn) const {
+    visit_all(Root.get(), fn);
+  }
+
+  std::size_t size() const {
+    return Root ? Root->Count : 0;
+  }
+
+  bool empty() const {
+    return Root == nullptr;
+  }
+
+  void swap(RangeMeasureSet<T>& other) {
+    Root.swap(other.Root);
+    std::swap(Seed, other.Seed);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, Root ? first(Root.get()) : nullptr);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, nullptr);
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  bool operator==(const RangeMeasureSet<T>& other) const {
+    if (size() != other.size())
+      return false;
+    for (auto lhs = begin(), rhs = other.begin(); lhs != end(); ++lhs, ++rhs) {
+      if (lhs.from() != rhs.from() || lhs.to() != rhs.to())
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const RangeMeasureSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    if (!Root)
+      return {0, 1.0};
+    return {Root->Sum, static_cast<double>(Root->Sum - Root->MaxSize) / Root->Sum};
+  }
+
+private:
+  // Assumptions that can be made about the data:
+  // - Ranges are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - 'from' is always smaller than 'to'
+  // - Stored ranges never overlap.
+  // - Stored ranges never touch.
+  // - The tree is a binary search tree on 'from' and a max-heap on 'Priority'.
+  // - Every node's 'Sum', 'Count' and 'MaxSize' describe its whole subtree.
+  // - Every node but the root has its parent as 'Parent'.
+  NodePtr Root;
+  uint32_t Seed = 0x9e3779b9u;
+
+  static std::size_t calc_size(T from, T to) {
+    if constexpr (std::is_pointer_v<T>) {
+      // For pointers we don't want pointer arithmetic here, else void* breaks.
+      return reinterpret_cast<std::size_t>(to) - reinterpret_cast<std::size_t>(from);
+    } else {
+      return static_cast<std::size_t>(to - from);
+    }
+  }
+
+  static std::size_t max_size(std::size_t a, std::size_t b) {
+    return a < b ? b : a;
+  }
+
+  uint32_t next_priority() {
+    // xorshift32, we just need something cheap that doesn't repeat quickly.
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+  }
+
+  // Recalculates the subtree values of 'node' and points its children back at it. Every change to a node's children is
+  // followed by this, so only the root of a tree can have an outdated 'Parent'.
+  static void update(Node* node) {
+    node->Sum = calc_size(node->From, node->To);
+    node->Count = 1;
+    node->MaxSize = node->Sum;
+    for (Node* child : {node->Left.get(), node->Right.get()}) {
+      if (child) {
+        child->Parent = node;
+        node->Sum += child->Sum;
+        node->Count += child->Count;
+        node->MaxSize = max_size(node->MaxSize, child->MaxSize);
+      }
+    }
+  }
+
+  // Splits the tree into the ranges starting before 'key' and the rest.
+  static std::pair<NodePtr, NodePtr> split(NodePtr node, T key) {
+    if (!node)
+      return {nullptr, nullptr};
+    if (node->From < key) {
+      auto parts = split(std::move(node->Right), key);
+      node->Right = std::move(parts.first);
+      update(node.get());
+      return {std::move(node), std::move(parts.second)};
+    } else {
+      auto parts = split(std::move(node->Left), key);
+      node->Left = std::move(parts.second);
+      update(node.get());
+      return {std::move(parts.first), std::move(node)};
+    }
+  }
+
+  // Splits the tree into the ranges starting at or before 'key' and the rest.
+  static std::pair<NodePtr, NodePtr> split_after(NodePtr node, T key) {
+    if (!node)
+      return {nullptr, nullptr};
+    if (!(key < node->From)) {
+      auto parts = split_after(std::move(node->Right), key);
+      node->Right = std::move(parts.first);
+      update(node.get());
+      return {std::move(node), std::move(parts.second)};
+    } else {
+      auto parts = split_after(std::move(node->Left), key);
+      node->Left = std::move(parts.second);
+      update(node.get());
+      return {std::move(parts.first), std::move(node)};
+    }
+  }
+
+  // Joins two trees where all ranges in 'left' are ordered before all ranges in 'right'.
+  static NodePtr merge(NodePtr left, NodePtr right) {
+    if (!left)
+      return right;
+    if (!right)
+      return left;
+    if (left->Priority > right->Priority) {
+      left->Right = merge(std::move(left->Right), std::move(right));
+      update(left.get());
+      return left;
+    } else {
+      right->Left = merge(std::move(left), std::move(right->Left));
+      update(right.get());
+      return right;
+    }
+  }
+
+  static const Node* first(const Node* node) {
+    while (node->Left)
+      node = node->Left.get();
+    return node;
+  }
+
+  static const Node* last(const Node* node) {
+    while (node->Right)
+      node = node->Right.get();
+    return node;
+  }
+
+  // Detaches and returns the first node of a non-empty tree.
+  static NodePtr pop_first(NodePtr& node) {
+    if (!node->Left) {
+      NodePtr result = std::move(node);
+      node = std::move(result->Right);
+      return result;
+    }
+    NodePtr result = pop_first(node->Left);
+    update(node.get());
+    return result;
+  }
+
+  // Detaches and returns the last node of a non-empty tree.
+  static NodePtr pop_last(NodePtr& node) {
+    if (!node->Right) {
+      NodePtr result = std::move(node);
+      node = std::move(result->Left);
+      return result;
+    }
+    NodePtr result = pop_last(node->Right);
+    update(node.get());
+    return result;
+  }
+
+  const Node* find_last_starting_before(T key) const {
+    const Node* result = nullptr;
+    const Node* node = Root.get();
+    while (node) {
+      if (node->From < key) {
+        result = node;
+        node = node->Right.get();
+      } else {
+        node = node->Left.get();
+      }
+    }
+    return result;
+  }
+
+  // The range containing 'value', or nullptr if there is none.
+  const Node* find_node(T value) const {
+    const Node* result = nullptr;
+    const Node* node = Root.get();
+    while (node) {
+      if (value < node->From) {
+        node = node->Left.get();
+      } else {
+        result = node;
+        node = node->Right.get();
+      }
+    }
+    return result && value < result->To ? result : nullptr;
+  }
+
+  // Number of values before 'key' that are in the set.
+  std::size_t covered_before(T key) const {
+    std::size_t result = 0;
+    const Node* node = Root.get();
+    while (node) {
+      if (node->From < key) {
+        if (node->Left)
+          result += node->Left->Sum;
+        result += calc_size(node->From, node->To < key ? node->To : key);
+        node = node->Right.get();
+      } else {
+        node = node->Left.get();
+      }
+    }
+    return result;
+  }
+
+  std::size_t count_starting_before(T key) const {
+    std::size_t result = 0;
+    const Node* node = Root.get();
+    while (node) {
+      if (node->From < key) {
+        result += (node->Left ? node->Left->Count : 0) + 1;
+        node = node->Right.get();
+      } else {
+        node = node->Left.get();
+      }
+    }
+    return result;
+  }
+
+  std::size_t count_ending_at_or_before(T key) const {
+    std::size_t result = 0;
+    const Node* node = Root.get();
+    while (node) {
+      if (!(key < node->To)) {
+        result += (node->Left ? node->Left->Count : 0) + 1;
+        node = node->Right.get();
+      } else {
+        node = node->Left.get();
+      }
+    }
+    return result;
+  }
+
+  // Largest size of the ranges that lie entirely within [lo, hi[.
+  static std::size_t max_within(const Node* node, T lo, T hi) {
+    while (node) {
+      if (node->From < lo) {
+        node = node->Right.get();
+      } else if (hi < node->To) {
+        node = node->Left.get();
+      } else {
+        // Ranges left of this node end before it and thus before 'hi', ranges right of it start after 'lo'.
+        return max_size(calc_size(node->From, node->To),
+                        max_size(max_starting_at_or_after(node->Left.get(), lo),
+                                 max_ending_at_or_before(node->Right.get(), hi)));
+      }
+    }
+    return 0;
+  }
+
+  static std::size_t max_starting_at_or_after(const Node* node, T lo) {
+    std::size_t result = 0;
+    while (node) {
+      if (node->From < lo) {
+        node = node->Right.get();
+      } else {
+        result = max_size(result, calc_size(node->From, node->To));
+        if (node->Right)
+          result = max_size(result, node->Right->MaxSize);
+        node = node->Left.get();
+      }
+    }
+    return result;
+  }
+
+  static std::size_t max_ending_at_or_before(const Node* node, T hi) {
+    std::size_t result = 0;
+    while (node) {
+      if (hi < node->To) {
+        node = node->Left.get();
+      } else {
+        result = max_size(result, calc_size(node->From, node->To));
+        if (node->Left)
+          result = max_size(result, node->Left->MaxSize);
+        node = node->Right.get();
+      }
+    }
+    return result;
+  }
+
+  template <typename F> static void visit_all(const Node* node, F& fn) {
+    if (!node)
+      return;
+    visit_all(node->Left.get(), fn);
+    fn(node->From, node->To);
+    visit_all(node->Right.get(), fn);
+  }
+
+  static NodePtr clone(const NodePtr& node) {
+    if (!node)
+      return nullptr;
+    NodePtr copy = std::make_unique<Node>(node->From, node->To, node->Priority);
+    copy->Left = clone(node->Left);
+    copy->Right = clone(node->Right);
+    update(copy.get());
+    return copy;
+  }
+};
+} // namespace HyoutaUtilities
@@ -2,11 +2,39 @@
 
 #include <cassert>
 #include <cstddef>
+#include <iterator>
 #include <map>
+#include <type_traits>
 #include <utility>
 
+#include "rangeerase.h"
+
 namespace HyoutaUtilities {
-template <typename T> class RangeSet {
+// Default observer for RangeSet that ignores all changes.
+// A custom observer must provide the same member functions. They are called right after the change has been applied,
+// and replaying them in order on a copy of the set reproduces the set. Observers must not modify the set.
+template <typename T> struct NullRangeObserver {
+  // A new range [from, to[ was added.
+  void range_added(T /*from*/, T /*to*/) {}
+
+  // The range [from, to[ was removed.
+  void range_removed(T /*from*/, T /*to*/) {}
+
+  // The range starting at 'from' now ends at 'new_to' instead of 'old_to'.
+  void range_expanded(T /*from*/, T /*old_to*/, T /*new_to*/) {}
+
+  // The range [old_from, old_to[ is now [new_from, new_to[, which lies within it.
+  void range_shrunk(T /*old_from*/, T /*old_to*/, T /*new_from*/, T /*new_to*/) {}
+
+  // The range [from, to[ lost [hole_from, hole_to[ from its middle and is now [from, hole_from[ and [hole_to, to[.
+  void range_split(T /*from*/, T /*to*/, T /*hole_from*/, T /*hole_to*/) {}
+
+  // The range [absorbed_from, absorbed_to[ was merged into the range starting at 'from', which now ends at 'to'.
+  void range_merged(T /*from*/, T /*to*/, T /*absorbed_from*/, T /*absorbed_to*/) {}
+};
+
+// The observer is stored as a (usually empty) base class so the default one takes no space.
+template <typename T, typename Observer = NullRangeObserver<T>> class RangeSet : private Observer {
 private:
   using MapT = std::map<T, T>;
 
@@ -57,158 +85,163 @@ public:
     friend class RangeSet;
   };
 
+  RangeSet() = default;
+  explicit RangeSet(Observer observer) : Observer(std::move(observer)) {}
+
   void insert(T from, T to) {
     if (from >= to)
       return;
 
+    // Ranges arriving in ascending order can only affect the last range, so skip the lookup for them.
+    if (!Map.empty() && get_from(std::prev(Map.end())) <= from) {
+      insert_before(Map.end(), from, to);
+      return;
+    }
+
     // Start by finding the closest range.
     // upper_bound() returns the closest range whose starting position
     // is greater than 'from'.
-    auto bound = Map.upper_bound(from);
-    if (bound == Map.end()) {
-      // There is no range that starts greater than the given one.
-      // This means we have three options:
-      // - 1. No range exists yet, this is the first range.
-      if (Map.empty()) {
-        insert_range(from, to);
-        return;
-      }
+    insert_before(Map.upper_bound(from), from, to);
+  }
 
-      // - 2. The given range does not overlap the last range.
-      --bound;
-      if (from > get_to(bound)) {
-        insert_range(from, to);
-        return;
-      }
+  // Inserts a range that starts at or after the start of the last range. This only needs to look at the last range, and
+  // either extends it or adds the new range at the end in amortized constant time, which makes building a set from
+  // sorted ranges cheap. Other ranges are inserted like with insert(). Returns the range that now contains [from, to[,
+  // or end() if the given range was empty.
+  const_iterator append(T from, T to) {
+    if (from >= to)
+      return end();
+    if (Map.empty() || get_from(std::prev(Map.end())) <= from)
+      return const_iterator(insert_before(Map.end(), from, to));
+    return const_iterator(insert_before(Map.upper_bound(from), from, to));
+  }
 
-      // - 3. The given range does overlap the last range.
-      maybe_expand_to(bound, to);
-      return;
-    }
+  // Like insert(T, T), but skips looking up the position if 'hint' is the range starting right after 'from' or the
+  // range before that. Returns the range that now contains [from, to[, which is a good hint for inserting the next
+  // higher range, or 'hint' if nothing was inserted.
+  const_iterator insert(const_iterator hint, T from, T to) {
+    if (from >= to)
+      return hint;
+    return const_iterator(insert_before(upper_bound_from_hint(hint.It, from), from, to));
+  }
 
-    if (bound == Map.begin()) {
-      // The given range starts before any of the existing ones.
-      // We must insert this as a new range even if we potentially overlap
-      // an existing one as we can't modify a key in a std::map.
-      auto inserted = insert_range(from, to);
-      merge_from_iterator_to_value(inserted, bound, to);
+  void erase(T from, T to) {
+    if (from >= to)
       return;
-    }
 
-    auto abound = bound--;
-
-    // 'bound' now points at the first range in the map that
-    // could possibly be affected.
+    // Like insert(), we use upper_bound to find the closest range.
+    erase_before(Map.upper_bound(from), from, to);
+  }
 
-    // If 'bound' overlaps with given range, update bounds object.
-    if (get_to(bound) >= from) {
-      maybe_expand_to(bound, to);
-      auto inserted = bound;
-      ++bound;
-      merge_from_iterator_to_value(inserted, bound, to);
-      return;
-    }
+  // Like erase(T, T), but skips looking up the position if 'hint' is the range starting right after 'from' or the
+  // range before that. Returns the first range starting at or after 'to', which is a good hint for erasing the next
+  // higher range, or 'hint' if nothing was erased.
+  const_iterator erase(const_iterator hint, T from, T to) {
+    if (from >= to)
+      return hint;
+    return const_iterator(erase_before(upper_bound_from_hint(hint.It, from), from, to));
+  }
 
-    // 'bound' *doesn't* overlap with given range, check next range.
+  const_iterator erase(const_iterator it) {
+    return const_iterator(erase_range(it.It));
+  }
 
-    // If this range overlaps with given range,
-    if (get_from(abound) <= to) {
-      // insert new range
-      auto inserted = insert_range(from, to >= get_to(abound) ? to : get_to(abound));
-      // and delete overlaps
-      abound = erase_range(abound);
-      merge_from_iterator_to_value(inserted, abound, to);
-      return;
+  void clear() {
+    if constexpr (std::is_same_v<Observer, NullRangeObserver<T>>) {
+      Map.clear();
+    } else {
+      MapT old;
+      old.swap(Map);
+      for (auto it = old.cbegin(); it != old.cend(); ++it)
+        observer().range_removed(get_from(it), get_to(it));
     }
+  }
 
-    // Otherwise, if we come here, then this new range overlaps nothing
-    // and must be inserted as a new range.
-    insert_range(from, to);
+  // Moves all values at or after 'key' into the returned set, splitting a range that reaches across 'key'.
+  // The map nodes are relinked instead of copied, so after finding 'key' this costs amortized constant time per moved
+  // range. The returned set gets 'result_observer', which must describe an empty set, and which is then told about every
+  // range moved into it, so the observer contract holds for both sets.
+  RangeSet<T, Observer> split_at(T key, Observer result_observer = Observer()) {
+    RangeSet<T, Observer> result(std::move(result_observer));
+    auto it = Map.lower_bound(key);
+    if (it != Map.begin()) {
+      auto prev = std::prev(it);
+      if (key < get_to(prev)) {
+        const T prevto = get_to(prev);
+        reduce_to(prev, key);
+        result.insert_range(result.Map.end(), key, prevto);
+      }
+    }
+    while (it != Map.end()) {
+      auto next = std::next(it);
+      move_node(it, result, result.Map.end());
+      it = next;
+    }
+    return result;
   }
 
-  void erase(T from, T to) {
-    if (from >= to)
+  // Moves all ranges of 'other' into this set, relinking its map nodes instead of copying them. Either all ranges of
+  // 'other' must lie after all ranges of this set, or the other way around; ranges touching at the seam are merged.
+  void join(RangeSet<T, Observer>&& other) {
+    if (other.Map.empty())
       return;
 
-    // Like insert(), we use upper_bound to find the closest range.
-    auto bound = Map.upper_bound(from);
-    if (bound == Map.end()) {
-      // There is no range that starts greater than the given one.
-      if (Map.empty()) {
-        // nothing to do
-        return;
-      }
-      --bound;
-      // 'bound' now points at the last range.
-      if (from >= get_to(bound)) {
-        // Given range is larger than any range that exists, nothing to do.
-        return;
+    if (Map.empty() || get_to(std::prev(Map.end())) <= get_from(other.Map.begin())) {
+      // 'other' goes after this set.
+      auto it = other.Map.begin();
+      if (!Map.empty() && get_to(std::prev(Map.end())) == get_from(it)) {
+        const T itto = get_to(it);
+        it = other.erase_range(it);
+        expand_to(std::prev(Map.end()), itto);
       }
-
-      if (to >= get_to(bound)) {
-        if (from == get_from(bound)) {
-          // Given range fully overlaps last range, erase it.
-          erase_range(bound);
-          return;
-        } else {
-          // Given range overlaps end of last range, reduce it.
-          reduce_to(bound, from);
-          return;
-        }
+      while (it != other.Map.end()) {
+        auto next = std::next(it);
+        other.move_node(it, *this, Map.end());
+        it = next;
       }
-
-      if (from == get_from(bound)) {
-        // Given range overlaps begin of last range, reduce it.
-        reduce_from(bound, to);
-        return;
-      } else {
-        // Given range overlaps middle of last range, bisect it.
-        bisect_range(bound, from, to);
-        return;
-      }
-    }
-
-    if (bound == Map.begin()) {
-      // If we found the first range that means 'from' is before any stored range.
-      // This means we can just erase from start until 'to' and be done with it.
-      erase_from_iterator_to_value(bound, to);
       return;
     }
 
-    // check previous range
-    auto abound = bound--;
-
-    if (from == get_from(bound)) {
-      // Similarly, if the previous range starts with the given one, just erase until 'to'.
-      erase_from_iterator_to_value(bound, to);
-      return;
+    // 'other' goes before this set, so every range of it is inserted in front of our current first range.
+    assert(get_to(std::prev(other.Map.end())) <= get_from(Map.begin()));
+    auto first = Map.begin();
+    if (get_to(std::prev(other.Map.end())) == get_from(first)) {
+      auto last = std::prev(other.Map.end());
+      const T firstto = get_to(first);
+      first = erase_range(first);
+      other.expand_to(last, firstto);
+    }
+    for (auto it = other.Map.begin(); it != other.Map.end();) {
+      auto next = std::next(it);
+      other.move_node(it, *this, first);
+      it = next;
     }
+  }
 
-    // If we come here, the given range may or may not overlap part of the current 'bound'
-    // (but never the full range), which means we may need to update the end position of it,
-    // or possibly even split it into two.
-    if (from < get_to(bound)) {
-      if (to < get_to(bound)) {
-        // need to split in two
-        bisect_range(bound, from, to);
-        return;
+  // Inserts all ranges of 'other' and leaves it empty. Ranges that don't overlap or touch a range of this set are moved
+  // over by relinking their map nodes instead of being copied. 'other' is walked in order with the range handled last
+  // as the hint, which skips the lookup when the next range goes right after it or the range following it. Otherwise,
+  // such as when the ranges of both sets interleave, every range still costs a full O(log n) lookup.
+  void merge(RangeSet<T, Observer>&& other) {
+    auto hint = Map.begin();
+    while (!other.Map.empty()) {
+      auto src = other.Map.begin();
+      const T from = get_from(src);
+      const T to = get_to(src);
+      auto bound = upper_bound_from_hint(hint, from);
+      if (bound != Map.begin() && get_to(std::prev(bound)) >= from) {
+        // Overlaps or touches the previous range, extend that one instead.
+        auto prev = std::prev(bound);
+        other.erase_range(src);
+        maybe_expand_to(prev, to);
+        merge_from_iterator_to_value(prev, bound, to);
+        hint = prev;
       } else {
-        // just update end
-        reduce_to(bound, from);
+        auto inserted = other.move_node(src, *this, bound);
+        merge_from_iterator_to_value(inserted, std::next(inserted), to);
+        hint = inserted;
       }
     }
-
-    // and then just erase until 'to'
-    erase_from_iterator_to_value(abound, to);
-    return;
-  }
-
-  const_iterator erase(const_iterator it) {
-    return const_iterator(erase_range(it.It));
-  }
-
-  void clear() {
-    Map.clear();
   }
 
   bool contains(T value) const {
@@ -219,6 +252,27 @@ public:
     return get_from(it) <= value && value < get_to(it);
   }
 
+  // Returns the range that contains the given value, or end() if there is none.
+  const_iterator find(T value) const {
+    auto it = Map.upper_bound(value);
+    if (it == Map.begin())
+      return end();
+    --it;
+    if (value < get_to(it))
+      return const_iterator(it);
+    return end();
+  }
+
+  // Returns the first range that starts at or after the given value.
+  const_iterator lower_bound(T value) const {
+    return const_iterator(Map.lower_bound(value));
+  }
+
+  // Returns the first range that starts after the given value.
+  const_iterator upper_bound(T value) const {
+    return const_iterator(Map.upper_bound(value));
+  }
+
   std::size_t size() const {
     return Map.size();
   }
@@ -227,8 +281,18 @@ public:
     return Map.empty();
   }
 
-  void swap(RangeSet<T>& other) {
+  // The observers are swapped along with the contents, so each keeps following the ranges it has seen so far.
+  void swap(RangeSet<T, Observer>& other) {
     Map.swap(other.Map);
+    std::swap(observer(), other.observer());
+  }
+
+  Observer& observer() {
+    return *this;
+  }
+
+  const Observer& observer() const {
+    return *this;
   }
 
   const_iterator begin() const {
@@ -247,11 +311,11 @@ public:
     return const_iterator(Map.cend());
   }
 
-  bool operator==(const RangeSet<T>& other) const {
+  bool operator==(const RangeSet<T, Observer>& other) const {
     return this->Map == other.Map;
   }
 
-  bool operator!=(const RangeSet<T>& other) const {
+  bool operator!=(const RangeSet<T, Observer>& other) const {
     return !(*this == other);
   }
 
@@ -271,6 +335,9 @@ public:
   }
 
 private:
+  // Shares the logic for erasing spans with RangeMap.
+  friend struct RangeEraser;
+
   static std::size_t calc_size(T from, T to) {
     if constexpr (std::is_pointer_v<T>) {
       // For pointers we don't want pointer arithmetic here, else void* breaks.
@@ -305,34 +372,139 @@ private:
     return it->second;
   }
 
-  typename MapT::iterator insert_range(T from, T to) {
-    return Map.emplace(from, to).first;
+  // Inserts [from, to[, where 'bound' is the first range that starts after 'from'. Returns the range containing it.
+  typename MapT::iterator insert_before(typename MapT::iterator bound, T from, T to) {
+    if (bound == Map.end()) {
+      // There is no range that starts greater than the given one.
+      // This means we have three options:
+      // - 1. No range exists yet, this is the first range.
+      if (Map.empty()) {
+        return insert_range(Map.end(), from, to);
+      }
+
+      // - 2. The given range does not overlap the last range.
+      --bound;
+      if (from > get_to(bound)) {
+        return insert_range(Map.end(), from, to);
+      }
+
+      // - 3. The given range does overlap the last range.
+      maybe_expand_to(bound, to);
+      return bound;
+    }
+
+    if (bound == Map.begin()) {
+      // The given range starts before any of the existing ones.
+      // We must insert this as a new range even if we potentially overlap
+      // an existing one as we can't modify a key in a std::map.
+      auto inserted = insert_range(bound, from, to);
+      merge_from_iterator_to_value(inserted, bound, to);
+      return inserted;
+    }
+
+    auto abound = bound--;
+
+    // 'bound' now points at the first range in the map that
+    // could possibly be affected.
+
+    // If 'bound' overlaps with given range, update bounds object.
+    if (get_to(bound) >= from) {
+      maybe_expand_to(bound, to);
+      auto inserted = bound;
+      ++bound;
+      merge_from_iterator_to_value(inserted, bound, to);
+      return inserted;
+    }
+
+    // 'bound' *doesn't* overlap with given range, check next range.
+
+    // If this range overlaps with given range,
+    if (get_from(abound) <= to) {
+      // insert new range and merge the overlaps into it
+      auto inserted = insert_range(abound, from, to);
+      merge_from_iterator_to_value(inserted, abound, to);
+      return inserted;
+    }
+
+    // Otherwise, if we come here, then this new range overlaps nothing
+    // and must be inserted as a new range.
+    return insert_range(abound, from, to);
+  }
+
+  // Erases [from, to[, where 'bound' is the first range that starts after 'from'. Returns the first range starting at or
+  // after 'to'.
+  typename MapT::iterator erase_before(typename MapT::iterator bound, T from, T to) {
+    return RangeEraser::erase_before(*this, Map, bound, from, to);
+  }
+
+  // Returns what Map.upper_bound(from) would, using 'hint' instead if it is that range or the one before it.
+  typename MapT::iterator upper_bound_from_hint(typename MapT::const_iterator hint, T from) {
+    // Erasing an empty range is the usual way of turning a const_iterator into an iterator in constant time.
+    auto it = Map.erase(hint, hint);
+    if (it != Map.end() && get_from(it) <= from)
+      ++it;
+    if ((it == Map.end() || from < get_from(it)) && (it == Map.begin() || get_from(std::prev(it)) <= from))
+      return it;
+    return Map.upper_bound(from);
+  }
+
+  // 'hint' is the range the new one is inserted in front of.
+  typename MapT::iterator insert_range(typename MapT::const_iterator hint, T from, T to) {
+    auto it = Map.emplace_hint(hint, from, to);
+    observer().range_added(from, to);
+    return it;
+  }
+
+  // Moves the node of the range 'it' into 'target' without reallocating it, inserting it in front of 'hint'.
+  typename MapT::iterator move_node(typename MapT::iterator it, RangeSet<T, Observer>& target,
+                                    typename MapT::const_iterator hint) {
+    auto node = Map.extract(it);
+    const T from = node.key();
+    const T to = node.mapped();
+    auto inserted = target.Map.insert(hint, std::move(node));
+    observer().range_removed(from, to);
+    target.observer().range_added(from, to);
+    return inserted;
   }
 
   typename MapT::iterator erase_range(typename MapT::iterator it) {
-    return Map.erase(it);
+    const T from = get_from(it);
+    const T to = get_to(it);
+    auto next = Map.erase(it);
+    observer().range_removed(from, to);
+    return next;
   }
 
   typename MapT::const_iterator erase_range(typename MapT::const_iterator it) {
-    return Map.erase(it);
+    const T from = get_from(it);
+    const T to = get_to(it);
+    auto next = Map.erase(it);
+    observer().range_removed(from, to);
+    return next;
   }
 
-  void bisect_range(typename MapT::iterator it, T from, T to) {
+  typename MapT::iterator bisect_range(typename MapT::iterator it, T from, T to) {
     assert(get_from(it) < from);
     assert(get_from(it) < to);
     assert(get_to(it) > from);
     assert(get_to(it) > to);
     assert(from < to);
+    T itfrom = get_from(it);
     T itto = get_to(it);
-    reduce_to(it, from);
-    insert_range(to, itto);
+    it->second = from;
+    auto upper = Map.emplace_hint(std::next(it), to, itto);
+    observer().range_split(itfrom, itto, from, to);
+    return upper;
   }
 
   typename MapT::iterator reduce_from(typename MapT::iterator it, T from) {
     assert(get_from(it) < from);
+    T itfrom = get_from(it);
     T itto = get_to(it);
-    erase_range(it);
-    return insert_range(from, itto);
+    auto next = Map.erase(it);
+    auto inserted = Map.emplace_hint(next, from, itto);
+    observer().range_shrunk(itfrom, itto, from, itto);
+    return inserted;
   }
 
   void maybe_expand_to(typename MapT::iterator it, T to) {
@@ -344,51 +516,107 @@ private:
 
   void expand_to(typename MapT::iterator it, T to) {
     assert(get_to(it) < to);
+    T itto = get_to(it);
     it->second = to;
+    observer().range_expanded(get_from(it), itto, to);
   }
 
   void reduce_to(typename MapT::iterator it, T to) {
     assert(get_to(it) > to);
+    T itto = get_to(it);
     it->second = to;
+    observer().range_shrunk(get_from(it), itto, get_from(it), to);
   }
 
   void merge_from_iterator_to_value(typename MapT::iterator inserted, typename MapT::iterator bound, T to) {
     // Erase all ranges that overlap the inserted while updating the upper end.
     while (bound != Map.end() && get_from(bound) <= to) {
-      maybe_expand_to(inserted, get_to(bound));
-      bound = erase_range(bound);
+      const T absorbed_from = get_from(bound);
+      const T absorbed_to = get_to(bound);
+      if (get_to(inserted) < absorbed_to)
+        inserted->second = absorbed_to;
+      bound = Map.erase(bound);
+      observer().range_merged(get_from(inserted), get_to(inserted), absorbed_from, absorbed_to);
     }
   }
+};
 
-  void erase_from_iterator_to_value(typename MapT::iterator bound, T to) {
-    // Assumption: Given bound starts at or after the 'from' value of the range to erase.
-    while (true) {
-      // Given range starts before stored range.
-      if (to <= get_from(bound)) {
-        // Range ends before this range too, nothing to do.
-        return;
-      }
+// Compares two sets in a single walk over both. Every range that is in 'b' but not in 'a' is written to 'added' and every
+// range that is in 'a' but not in 'b' is written to 'removed', both as std::pair<T, T>{from, to} and in order.
+// Ranges that are identical in both sets are skipped with a single comparison each.
+template <typename T, typename ObserverA, typename ObserverB, typename AddedOut, typename RemovedOut>
+void diff(const RangeSet<T, ObserverA>& a, const RangeSet<T, ObserverB>& b, AddedOut added, RemovedOut removed) {
+  auto ita = a.begin();
+  auto itb = b.begin();
+
+  // The parts of the current ranges that haven't been looked at yet.
+  T afrom{};
+  T ato{};
+  T bfrom{};
+  T bto{};
+  if (ita != a.end()) {
+    afrom = ita.from();
+    ato = ita.to();
+  }
+  if (itb != b.end()) {
+    bfrom = itb.from();
+    bto = itb.to();
+  }
+  auto next_a = [&] {
+    if (++ita != a.end()) {
+      afrom = ita.from();
+      ato = ita.to();
+    }
+  };
+  auto next_b = [&] {
+    if (++itb != b.end()) {
+      bfrom = itb.from();
+      bto = itb.to();
+    }
+  };
 
-      if (to < get_to(bound)) {
-        // Range ends in the middle of current range, reduce current.
-        reduce_from(bound, to);
-        return;
-      }
+  while (ita != a.end() && itb != b.end()) {
+    if (afrom == bfrom && ato == bto) {
+      next_a();
+      next_b();
+      continue;
+    }
 
-      if (to == get_to(bound)) {
-        // Range ends exactly with current range, erase current.
-        erase_range(bound);
-        return;
-      }
+    // No overlap, the earlier one is entirely added or removed.
+    if (ato <= bfrom) {
+      *removed++ = std::pair<T, T>(afrom, ato);
+      next_a();
+      continue;
+    }
+    if (bto <= afrom) {
+      *added++ = std::pair<T, T>(bfrom, bto);
+      next_b();
+      continue;
+    }
 
-      // Range ends later than current range.
-      // First erase current, then loop to check the range(s) after this one too.
-      bound = erase_range(bound);
-      if (bound == Map.end()) {
-        // Unless that was the last range, in which case there's nothing else to do.
-        return;
-      }
+    // The ranges overlap, so whatever sticks out at the front differs and the common part is skipped.
+    if (afrom < bfrom) {
+      *removed++ = std::pair<T, T>(afrom, bfrom);
+      afrom = bfrom;
+    } else if (bfrom < afrom) {
+      *added++ = std::pair<T, T>(bfrom, afrom);
+      bfrom = afrom;
+    }
+    if (ato < bto) {
+      bfrom = ato;
+      next_a();
+    } else if (bto < ato) {
+      afrom = bto;
+      next_b();
+    } else {
+      next_a();
+      next_b();
     }
   }
-};
+
+  for (; ita != a.end(); next_a())
+    *removed++ = std::pair<T, T>(afrom, ato);
+  for (; itb != b.end(); next_b())
+    *added++ = std::pair<T, T>(bfrom, bto);
+}
 } // namespace HyoutaUtilities
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitutils.h"
+#include "rangeset.h"
+
+namespace HyoutaUtilities {
+// Multithreaded bulk operations on sorted lists of ranges, and on RangeSets by way of such lists.
+// A 'thread_count' of 0 means to use as many threads as the hardware supports.
+namespace ParallelDetail {
+// Inputs smaller than this are not worth spinning up threads for.
+constexpr std::size_t MinItemsPerThread = 4096;
+
+inline unsigned resolve_thread_count(unsigned thread_count, std::size_t items) {
+  if (thread_count == 0) {
+    thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0)
+      thread_count = 1;
+  }
+  const std::size_t useful = items / MinItemsPerThread;
+  if (useful < thread_count)
+    thread_count = useful == 0 ? 1 : static_cast<unsigned>(useful);
+  return thread_count;
+}
+
+// Calls fn(i) for every i in [0, tasks[, each on its own thread. The calling thread runs task 0.
+template <typename F> void run_tasks(std::size_t tasks, F&& fn) {
+  std::vector<std::thread> workers;
+  workers.reserve(tasks > 0 ? tasks - 1 : 0);
+  for (std::size_t i = 1; i < tasks; ++i)
+    workers.emplace_back([&fn, i] { fn(i); });
+  if (tasks > 0)
+    fn(0);
+  for (auto& worker : workers)
+    worker.join();
+}
+
+// Sorts each of 'parts' slices on its own thread, then merges neighboring slices pairwise in parallel rounds.
+template <typename It> void parallel_sort(It begin, It end, unsigned parts) {
+  const std::size_t count = static_cast<std::size_t>(end - begin);
+  if (parts <= 1) {
+    std::sort(begin, end);
+    return;
+  }
+
+  std::vector<It> bounds(parts + 1);
+  for (unsigned i = 0; i <= parts; ++i)
+    bounds[i] = begin + static_cast<std::ptrdiff_t>(count * i / parts);
+  run_tasks(parts, [&](std::size_t i) { std::sort(bounds[i], bounds[i + 1]); });
+
+  for (std::size_t width = 1; width < parts; width *= 2) {
+    const std::size_t merges = (parts + 2 * width - 1) / (2 * width);
+    run_tasks(merges, [&](std::size_t m) {
+      const std::size_t lo = m * 2 * width;
+      const std::size_t mid = std::min<std::size_t>(lo + width, parts);
+      const std::size_t hi = std::min<std::size_t>(lo + 2 * width, parts);
+      if (mid < hi)
+        std::inplace_merge(bounds[lo], bounds[mid], bounds[hi]);
+    });
+  }
+}
+
+// Appends the given range to a sorted list of ranges, merging it with the last one if they overlap or touch.
+template <typename T> void append_coalesced(std::vector<std::pair<T, T>>& out, T from, T to) {
+  if (from >= to)
+    return;
+  if (!out.empty() && from <= out.back().second) {
+    if (to > out.back().second)
+      out.back().second = to;
+    return;
+  }
+  out.emplace_back(from, to);
+}
+
+// Concatenates per-task results, merging ranges that touch across task boundaries.
+template <typename T> std::vector<std::pair<T, T>> stitch(std::vector<std::vector<std::pair<T, T>>>& parts) {
+  std::size_t total = 0;
+  for (const auto& part : parts)
+    total += part.size();
+  std::vector<std::pair<T, T>> result;
+  result.reserve(total);
+  for (const auto& part : parts) {
+    for (const auto& range : part)
+      append_coalesced(result, range.first, range.second);
+  }
+  return result;
+}
+
+// Splits the key space into up to 'parts' slices with about equal numbers of ranges from 'a', and calls
+// fn(task, a_slice, b_slice) for each, where the slices are the ranges of 'a' and 'b' clipped to that part of the
+// key space. Returns the stitched results of all tasks.
+template <typename T, typename F>
+std::vector<std::pair<T, T>> for_each_key_slice(const std::vector<std::pair<T, T>>& a,
+                                                const std::vector<std::pair<T, T>>& b, unsigned parts, F&& fn) {
+  // Pick split keys from the starts of evenly spaced ranges in 'a'.
+  std::vector<T> splits;
+  for (unsigned i = 1; i < parts; ++i) {
+    const T key = a[a.size() * i / parts].first;
+    if (splits.empty() || splits.back() < key)
+      splits.push_back(key);
+  }
+
+  const std::size_t tasks = splits.size() + 1;
+  std::vector<std::vector<std::pair<T, T>>> results(tasks);
+  run_tasks(tasks, [&](std::size_t task) {
+    const bool has_lo = task > 0;
+    const bool has_hi = task < splits.size();
+    const T lo = has_lo ? splits[task - 1] : T();
+    const T hi = has_hi ? splits[task] : T();
+
+    auto clip = [&](const std::vector<std::pair<T, T>>& ranges) {
+      // First range that ends after 'lo' up to the first range that starts at or after 'hi'.
+      auto first = has_lo ? std::partition_point(ranges.begin(), ranges.end(),
+                                                 [&](const std::pair<T, T>& r) { return r.second <= lo; })
+                          : ranges.begin();
+      auto last = has_hi ? std::partition_point(first, ranges.end(),
+                                                [&](const std::pair<T, T>& r) { return r.first < hi; })
+                         : ranges.end();
+      std::vector<std::pair<T, T>> clipped(first, last);
+      if (!clipped.empty()) {
+        if (has_lo && clipped.front().first < lo)
+          clipped.front().first = lo;
+        if (has_hi && clipped.back().second > hi)
+          clipped.back().second = hi;
+      }
+      return clipped;
+    };
+
+    fn(results[task], clip(a), clip(b));
+  });
+  return stitch(results);
+}
+
+template <typename T>
+void union_sorted(std::vector<std::pair<T, T>>& out, const std::vector<std::pair<T, T>>& a,
+                  const std::vector<std::pair<T, T>>& b) {
+  out.reserve(a.size() + b.size());
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < a.size() || j < b.size()) {
+    if (j == b.size() || (i < a.size() && a[i].first < b[j].first)) {
+      append_coalesced(out, a[i].first, a[i].second);
+      ++i;
+    } else {
+      append_coalesced(out, b[j].first, b[j].second);
+      ++j;
+    }
+  }
+}
+
+template <typename T>
+void intersect_sorted(std::vector<std::pair<T, T>>& out, const std::vector<std::pair<T, T>>& a,
+                      const std::vector<std::pair<T, T>>& b) {
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    const T from = a[i].first < b[j].first ? b[j].first : a[i].first;
+    const T to = a[i].second < b[j].second ? a[i].second : b[j].second;
+    if (from < to)
+      out.emplace_back(from, to);
+    if (a[i].second < b[j].second)
+      ++i;
+    else
+      ++j;
+  }
+}
+} // namespace ParallelDetail
+
+// Sorts the given ranges and merges all overlapping or touching ones, like inserting them into a RangeSet would.
+// Empty ranges are dropped.
+template <typename T>
+std::vector<std::pair<T, T>> coalesce_ranges_parallel(std::vector<std::pair<T, T>> ranges, unsigned thread_count = 0) {
+  const unsigned parts = ParallelDetail::resolve_thread_count(thread_count, ranges.size());
+  ParallelDetail::parallel_sort(ranges.begin(), ranges.end(), parts);
+
+  // Coalesce each slice on its own, then stitch the slices together.
+  std::vector<std::vector<std::pair<T, T>>> results(parts);
+  ParallelDetail::run_tasks(parts, [&](std::size_t i) {
+    const std::size_t begin = ranges.size() * i / parts;
+    const std::size_t end = ranges.size() * (i + 1) / parts;
+    for (std::size_t j = begin; j < end; ++j)
+      ParallelDetail::append_coalesced(results[i], ranges[j].first, ranges[j].second);
+  });
+  return ParallelDetail::stitch(results);
+}
+
+// Builds a RangeSet from the given ranges, equivalent to inserting each of them.
+template <typename T> RangeSet<T> build_range_set_parallel(std::vector<std::pair<T, T>> ranges, unsigned thread_count = 0) {
+  RangeSet<T> result;
+  for (const auto& range : coalesce_ranges_parallel(std::move(ranges), thread_count))
+    result.insert(range.first, range.second);
+  return result;
+}
+
+// Returns the ranges of a RangeSet as a sorted list.
+template <typename T> std::vector<std::pair<T, T>> to_range_vector(const RangeSet<T>& rs) {
+  std::vector<std::pair<T, T>> result;
+  result.reserve(rs.size());
+  for (auto it = rs.begin(); it != rs.end(); ++it)
+    result.emplace_back(it.from(), it.to());
+  return result;
+}
+
+// Union of two sorted lists of non-overlapping, non-touching ranges.
+template <typename T>
+std::vector<std::pair<T, T>> union_parallel(const std::vector<std::pair<T, T>>& a,
+                                            const std::vector<std::pair<T, T>>& b, unsigned thread_count = 0) {
+  if (a.size() < b.size())
+    return union_parallel(b, a, thread_count);
+  const unsigned parts = ParallelDetail::resolve_thread_count(thread_count, a.size() + b.size());
+  if (parts <= 1 || a.empty()) {
+    std::vector<std::pair<T, T>> result;
+    ParallelDetail::union_sorted(result, a, b);
+    return result;
+  }
+  return ParallelDetail::for_each_key_slice(a, b, parts, [](auto& out, const auto& sa, const auto& sb) {
+    ParallelDetail::union_sorted(out, sa, sb);
+  });
+}
+
+// Intersection of two sorted lists of non-overlapping, non-touching ranges.
+template <typename T>
+std::vector<std::pair<T, T>> intersection_parallel(const std::vector<std::pair<T, T>>& a,
+                                                   const std::vector<std::pair<T, T>>& b,
+                                                   unsigned thread_count = 0) {
+  if (a.size() < b.size())
+    return intersection_parallel(b, a, thread_count);
+  const unsigned parts = ParallelDetail::resolve_thread_count(thread_count, a.size() + b.size());
+  if (parts <= 1 || a.empty()) {
+    std::vector<std::pair<T, T>> result;
+    ParallelDetail::intersect_sorted(result, a, b);
+    return result;
+  }
+  return ParallelDetail::for_each_key_slice(a, b, parts, [](auto& out, const auto& sa, const auto& sb) {
+    ParallelDetail::intersect_sorted(out, sa, sb);
+  });
+}
+
+template <typename T> RangeSet<T> union_parallel(const RangeSet<T>& a, const RangeSet<T>& b, unsigned thread_count = 0) {
+  RangeSet<T> result;
+  for (const auto& range : union_parallel(to_range_vector(a), to_range_vector(b), thread_count))
+    result.insert(range.first, range.second);
+  return result;
+}
+
+template <typename T>
+RangeSet<T> intersection_parallel(const RangeSet<T>& a, const RangeSet<T>& b, unsigned thread_count = 0) {
+  RangeSet<T> result;
+  for (const auto& range : intersection_parallel(to_range_vector(a), to_range_vector(b), thread_count))
+    result.insert(range.first, range.second);
+  return result;
+}
+
+// Calls 'accumulate(acc, from, to)' for every range that overlaps [lo, hi[, clipped to that window, and returns the
+// accumulated result. The window is split into equally wide slices that are walked on separate threads, each
+// accumulating into its own copy of 'init', which are then folded together in order with 'combine(acc, other)'.
+// So 'init' must be neutral for 'combine', and accumulating two halves and then combining them must give the same
+// result as accumulating everything at once.
+// 'accumulate' is called from several threads at the same time, so it must be thread-safe: apart from the 'acc' it is
+// given, it must not modify anything without synchronization. 'combine' is only called on the calling thread.
+template <typename T, typename Acc, typename Accumulate, typename Combine>
+Acc reduce_parallel(const RangeSet<T>& rs, T lo, T hi, Acc init, Accumulate&& accumulate, Combine&& combine,
+                    unsigned thread_count = 0) {
+  static_assert(std::is_integral_v<T>, "reduce_parallel only supports integers.");
+  if (lo >= hi)
+    return init;
+
+  // Each slice handles the ranges starting within it, the first one also the range that contains 'lo'.
+  const unsigned parts = ParallelDetail::resolve_thread_count(thread_count, rs.size());
+  std::vector<typename RangeSet<T>::const_iterator> bounds;
+  bounds.reserve(parts + 1);
+  auto first = rs.find(lo);
+  bounds.push_back(first != rs.end() ? first : rs.lower_bound(lo));
+  // Computed unsigned, as the width of the window may not fit into a signed T.
+  using UnsignedT = std::make_unsigned_t<T>;
+  const UnsignedT step = static_cast<UnsignedT>(static_cast<UnsignedT>(hi) - static_cast<UnsignedT>(lo)) / parts;
+  for (unsigned i = 1; i < parts; ++i)
+    bounds.push_back(rs.lower_bound(static_cast<T>(static_cast<UnsignedT>(lo) + step * i)));
+  bounds.push_back(rs.lower_bound(hi));
+
+  std::vector<Acc> partial(parts, init);
+  ParallelDetail::run_tasks(parts, [&](std::size_t i) {
+    for (auto it = bounds[i]; it != bounds[i + 1]; ++it)
+      accumulate(partial[i], it.from() < lo ? lo : it.from(), hi < it.to() ? hi : it.to());
+  });
+
+  Acc result = std::move(init);
+  for (const Acc& part : partial)
+    combine(result, part);
+  return result;
+}
+
+// Counts the ranges by size. Bucket 'i' counts the ranges with a size in [2^i, 2^(i+1)[, except that the last bucket
+// also counts all larger ranges.
+template <typename T>
+std::vector<std::size_t> size_histogram_parallel(const RangeSet<T>& rs, std::size_t buckets, unsigned thread_count = 0) {
+  std::vector<std::size_t> empty(buckets, 0);
+  if (rs.empty() || buckets == 0)
+    return empty;
+  return reduce_parallel(
+      rs, rs.begin().from(), (--rs.end()).to(), std::move(empty),
+      [](std::vector<std::size_t>& histogram, T from, T to) {
+        using UnsignedT = std::make_unsigned_t<T>;
+        const UnsignedT size = static_cast<UnsignedT>(static_cast<UnsignedT>(to) - static_cast<UnsignedT>(from));
+        const std::size_t bucket =
+            static_cast<std::size_t>(63 - BitUtils::count_leading_zeros(static_cast<uint64_t>(size)));
+        ++histogram[bucket < histogram.size() ? bucket : histogram.size() - 1];
+      },
+      [](std::vector<std::size_t>& histogram, const std::vector<std::size_t>& other) {
+        for (std::size_t i = 0; i < histogram.size(); ++i)
+          histogram[i] += other[i];
+      },
+      thread_count);
+}
+
+// Same result as RangeSet::get_stats().
+template <typename T> std::pair<std::size_t, double> get_stats_parallel(const RangeSet<T>& rs, unsigned thread_count = 0) {
+  if (rs.empty())
+    return {0, 1.0};
+
+  // Total and largest size.
+  using Stats = std::pair<std::size_t, std::size_t>;
+  const Stats stats = reduce_parallel(
+      rs, rs.begin().from(), (--rs.end()).to(), Stats(0, 0),
+      [](Stats& acc, T from, T to) {
+        const std::size_t size = static_cast<std::size_t>(to - from);
+        acc.first += size;
+        if (size > acc.second)
+          acc.second = size;
+      },
+      [](Stats& acc, const Stats& other) {
+        acc.first += other.first;
+        if (other.second > acc.second)
+          acc.second = other.second;
+      },
+      thread_count);
+  return {stats.first, static_cast<double>(stats.first - stats.second) / stats.first};
+}
+} // namespace HyoutaUtilities
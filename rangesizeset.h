@@ -2,16 +2,18 @@
 
 #include <cassert>
 #include <cstddef>
+#include <iterator>
 #include <map>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace HyoutaUtilities {
 // Like RangeSet, but additionally stores a map of the ranges sorted by their size, for quickly finding the largest or
 // smallest range.
 template <typename T> class RangeSizeSet {
 private:
-  // Key type used in the by-size multimap. Should be a type big enough to hold all possible distances between
+  // Key type used in the by-size map. Should be a type big enough to hold all possible distances between
   // possible 'from' and 'to'.
   // I'd actually love to just do
   // using SizeT = typename std::conditional<std::is_pointer_v<T>,
@@ -25,13 +27,40 @@ public:
   using SizeT = typename GetSizeType<T, std::is_pointer_v<T>>::S;
 
 private:
+  // Key type of the by-size map. The start of the range is included so that ranges of the same size have a fixed
+  // order, independent of the order they were inserted in.
+  struct SizeKey {
+    SizeT Size;
+    T From;
+  };
+
+  // Orders by size descending, then by address ascending. Lookups by size alone are supported, and see all ranges of
+  // that size as equal.
+  struct SizeKeyCompare {
+    using is_transparent = void;
+
+    bool operator()(const SizeKey& lhs, const SizeKey& rhs) const {
+      if (lhs.Size != rhs.Size)
+        return lhs.Size > rhs.Size;
+      return lhs.From < rhs.From;
+    }
+
+    bool operator()(const SizeKey& lhs, const SizeT& rhs) const {
+      return lhs.Size > rhs;
+    }
+
+    bool operator()(const SizeT& lhs, const SizeKey& rhs) const {
+      return lhs > rhs.Size;
+    }
+  };
+
   // Value type stored in the regular range map.
   struct Value {
     // End point of the range.
     T To;
 
-    // Pointer to the same range in the by-size multimap.
-    typename std::multimap<SizeT, typename std::map<T, Value>::iterator, std::greater<SizeT>>::iterator SizeIt;
+    // Pointer to the same range in the by-size map. Mutable so that a lazy size index can be rebuilt by a const lookup.
+    mutable typename std::map<SizeKey, typename std::map<T, Value>::const_iterator, SizeKeyCompare>::iterator SizeIt;
 
     Value(T to) : To(to) {}
 
@@ -45,7 +74,7 @@ private:
   };
 
   using MapT = std::map<T, Value>;
-  using SizeMapT = std::multimap<SizeT, typename MapT::iterator, std::greater<SizeT>>;
+  using SizeMapT = std::map<SizeKey, typename MapT::const_iterator, SizeKeyCompare>;
 
 public:
   struct by_size_const_iterator;
@@ -90,6 +119,7 @@ public:
       return !operator==(rhs);
     }
 
+    // With a lazy size index, the index must be up to date for this, see set_lazy_size_index().
     by_size_const_iterator to_size_iterator() {
       return by_size_const_iterator(It->second.SizeIt);
     }
@@ -164,66 +194,16 @@ public:
     // Start by finding the closest range.
     // upper_bound() returns the closest range whose starting position
     // is greater than 'from'.
-    auto bound = Map.upper_bound(from);
-    if (bound == Map.end()) {
-      // There is no range that starts greater than the given one.
-      // This means we have three options:
-      // - 1. No range exists yet, this is the first range.
-      if (Map.empty()) {
-        insert_range(from, to);
-        return;
-      }
-
-      // - 2. The given range does not overlap the last range.
-      --bound;
-      if (from > get_to(bound)) {
-        insert_range(from, to);
-        return;
-      }
-
-      // - 3. The given range does overlap the last range.
-      maybe_expand_to(bound, to);
-      return;
-    }
-
-    if (bound == Map.begin()) {
-      // The given range starts before any of the existing ones.
-      // We must insert this as a new range even if we potentially overlap
-      // an existing one as we can't modify a key in a std::map.
-      auto inserted = insert_range(from, to);
-      merge_from_iterator_to_value(inserted, bound, to);
-      return;
-    }
-
-    auto abound = bound--;
-
-    // 'bound' now points at the first range in the map that
-    // could possibly be affected.
-
-    // If 'bound' overlaps with given range, update bounds object.
-    if (get_to(bound) >= from) {
-      maybe_expand_to(bound, to);
-      auto inserted = bound;
-      ++bound;
-      merge_from_iterator_to_value(inserted, bound, to);
-      return;
-    }
-
-    // 'bound' *doesn't* overlap with given range, check next range.
-
-    // If this range overlaps with given range,
-    if (get_from(abound) <= to) {
-      // insert new range
-      auto inserted = insert_range(from, to >= get_to(abound) ? to : get_to(abound));
-      // and delete overlaps
-      abound = erase_range(abound);
-      merge_from_iterator_to_value(inserted, abound, to);
-      return;
-    }
+    insert_before(Map.upper_bound(from), from, to);
+  }
 
-    // Otherwise, if we come here, then this new range overlaps nothing
-    // and must be inserted as a new range.
-    insert_range(from, to);
+  // Like insert(T, T), but skips looking up the position if 'hint' is the range starting right after 'from' or the
+  // range before that. Returns the range that now contains [from, to[, which is a good hint for inserting the next
+  // higher range, or 'hint' if nothing was inserted.
+  const_iterator insert(const_iterator hint, T from, T to) {
+    if (from >= to)
+      return hint;
+    return const_iterator(insert_before(upper_bound_from_hint(hint.It, from), from, to));
   }
 
   void erase(T from, T to) {
@@ -231,76 +211,16 @@ public:
       return;
 
     // Like insert(), we use upper_bound to find the closest range.
-    auto bound = Map.upper_bound(from);
-    if (bound == Map.end()) {
-      // There is no range that starts greater than the given one.
-      if (Map.empty()) {
-        // nothing to do
-        return;
-      }
-      --bound;
-      // 'bound' now points at the last range.
-      if (from >= get_to(bound)) {
-        // Given range is larger than any range that exists, nothing to do.
-        return;
-      }
-
-      if (to >= get_to(bound)) {
-        if (from == get_from(bound)) {
-          // Given range fully overlaps last range, erase it.
-          erase_range(bound);
-          return;
-        } else {
-          // Given range overlaps end of last range, reduce it.
-          reduce_to(bound, from);
-          return;
-        }
-      }
-
-      if (from == get_from(bound)) {
-        // Given range overlaps begin of last range, reduce it.
-        reduce_from(bound, to);
-        return;
-      } else {
-        // Given range overlaps middle of last range, bisect it.
-        bisect_range(bound, from, to);
-        return;
-      }
-    }
-
-    if (bound == Map.begin()) {
-      // If we found the first range that means 'from' is before any stored range.
-      // This means we can just erase from start until 'to' and be done with it.
-      erase_from_iterator_to_value(bound, to);
-      return;
-    }
-
-    // check previous range
-    auto abound = bound--;
-
-    if (from == get_from(bound)) {
-      // Similarly, if the previous range starts with the given one, just erase until 'to'.
-      erase_from_iterator_to_value(bound, to);
-      return;
-    }
-
-    // If we come here, the given range may or may not overlap part of the current 'bound'
-    // (but never the full range), which means we may need to update the end position of it,
-    // or possibly even split it into two.
-    if (from < get_to(bound)) {
-      if (to < get_to(bound)) {
-        // need to split in two
-        bisect_range(bound, from, to);
-        return;
-      } else {
-        // just update end
-        reduce_to(bound, from);
-      }
-    }
+    erase_before(Map.upper_bound(from), from, to);
+  }
 
-    // and then just erase until 'to'
-    erase_from_iterator_to_value(abound, to);
-    return;
+  // Like erase(T, T), but skips looking up the position if 'hint' is the range starting right after 'from' or the
+  // range before that. Returns the first range starting at or after 'to', which is a good hint for erasing the next
+  // higher range, or 'hint' if nothing was erased.
+  const_iterator erase(const_iterator hint, T from, T to) {
+    if (from >= to)
+      return hint;
+    return const_iterator(erase_before(upper_bound_from_hint(hint.It, from), from, to));
   }
 
   const_iterator erase(const_iterator it) {
@@ -312,8 +232,83 @@ public:
   }
 
   void clear() {
+    if (InTransaction) {
+      for (auto it = Map.begin(); it != Map.end(); ++it)
+        UndoLog.push_back({UndoAction::Restore, get_from(it), get_to(it)});
+    }
     Map.clear();
     Sizes.clear();
+    SizesDirty = false;
+  }
+
+  // In lazy mode, changes to the set don't update the by-size map but only mark it as outdated, and it is rebuilt from
+  // scratch by the next by-size lookup. That is cheaper when many changes happen between by-size lookups, but every
+  // change then invalidates all by-size iterators, and to_size_iterator() only works after a by-size lookup.
+  // Turning lazy mode off brings the by-size map up to date right away.
+  // As the rebuild happens inside const by-size lookups, those are not safe to call from several threads at once in lazy
+  // mode, unlike other const member functions; call update_size_index() before sharing the set between readers.
+  void set_lazy_size_index(bool lazy) {
+    LazySizes = lazy;
+    if (!lazy)
+      update_size_index();
+  }
+
+  bool lazy_size_index() const {
+    return LazySizes;
+  }
+
+  // Rebuilds the by-size map if it is outdated. By-size lookups do this automatically.
+  void update_size_index() const {
+    if (!SizesDirty)
+      return;
+
+    Sizes.clear();
+    for (auto it = Map.begin(); it != Map.end(); ++it)
+      it->second.SizeIt = Sizes.emplace(SizeKey{calc_size(get_from(it), get_to(it)), get_from(it)}, it).first;
+    SizesDirty = false;
+  }
+
+  // Starts recording every change made to the set from now on, so they can be undone with rollback().
+  // This costs a small log entry per changed range instead of a copy of the whole set. Transactions do not nest.
+  void begin_transaction() {
+    assert(!InTransaction);
+    InTransaction = true;
+  }
+
+  // Keeps all changes made since begin_transaction().
+  void commit() {
+    assert(InTransaction);
+    InTransaction = false;
+    UndoLog.clear();
+  }
+
+  // Undoes all changes made since begin_transaction(), in reverse order.
+  void rollback() {
+    assert(InTransaction);
+    InTransaction = false;
+    for (auto entry = UndoLog.rbegin(); entry != UndoLog.rend(); ++entry) {
+      switch (entry->Action) {
+      case UndoAction::Remove:
+        erase_range(Map.find(entry->From));
+        break;
+      case UndoAction::Restore:
+        insert_range(Map.upper_bound(entry->From), entry->From, entry->To);
+        break;
+      case UndoAction::Resize: {
+        auto it = Map.find(entry->From);
+        if (entry->To < get_to(it))
+          reduce_to(it, entry->To);
+        else
+          expand_to(it, entry->To);
+        break;
+      }
+      }
+    }
+    UndoLog.clear();
+  }
+
+  bool in_transaction() const {
+    return InTransaction;
   }
 
   bool contains(T value) const {
@@ -333,30 +328,53 @@ public:
   }
 
   std::size_t by_size_count(const SizeT& key) const {
-    return Sizes.count(key);
+    return current_sizes().count(key);
   }
 
+  // Of several ranges of the given size, returns the one with the lowest address.
   by_size_const_iterator by_size_find(const SizeT& key) const {
-    return Sizes.find(key);
+    const SizeMapT& sizes = current_sizes();
+    auto it = sizes.lower_bound(key);
+    if (it != sizes.end() && it->first.Size == key)
+      return it;
+    return sizes.end();
   }
 
   std::pair<by_size_const_iterator, by_size_const_iterator> by_size_equal_range(const SizeT& key) const {
-    auto p = Sizes.equal_range(key);
+    auto p = current_sizes().equal_range(key);
     return std::pair<by_size_const_iterator, by_size_const_iterator>(by_size_const_iterator(p.first),
                                                                      by_size_const_iterator(p.second));
   }
 
   by_size_const_iterator by_size_lower_bound(const SizeT& key) const {
-    return Sizes.lower_bound(key);
+    return current_sizes().lower_bound(key);
   }
 
   by_size_const_iterator by_size_upper_bound(const SizeT& key) const {
-    return Sizes.upper_bound(key);
+    return current_sizes().upper_bound(key);
+  }
+
+  // Returns the smallest range that is at least 'size' big, or by_size_end() if there is none. Of several such ranges
+  // of the same size, the one with the lowest address is returned.
+  by_size_const_iterator by_size_best_fit(const SizeT& size) const {
+    const SizeMapT& sizes = current_sizes();
+    auto it = sizes.lower_bound(size);
+    if (it != sizes.end() && it->first.Size == size)
+      return it;
+    if (it == sizes.begin())
+      return sizes.end();
+
+    // The range before is the smallest one that is bigger, but the last of its size, so go to the first of its size.
+    return sizes.lower_bound(std::prev(it)->first.Size);
   }
 
   void swap(RangeSizeSet<T>& other) {
     Map.swap(other.Map);
     Sizes.swap(other.Sizes);
+    std::swap(LazySizes, other.LazySizes);
+    std::swap(SizesDirty, other.SizesDirty);
+    UndoLog.swap(other.UndoLog);
+    std::swap(InTransaction, other.InTransaction);
   }
 
   const_iterator begin() const {
@@ -376,19 +394,19 @@ public:
   }
 
   by_size_const_iterator by_size_begin() const {
-    return by_size_const_iterator(Sizes.begin());
+    return by_size_const_iterator(current_sizes().begin());
   }
 
   by_size_const_iterator by_size_end() const {
-    return by_size_const_iterator(Sizes.end());
+    return by_size_const_iterator(current_sizes().end());
   }
 
   by_size_const_iterator by_size_cbegin() const {
-    return by_size_const_iterator(Sizes.cbegin());
+    return by_size_const_iterator(current_sizes().cbegin());
   }
 
   by_size_const_iterator by_size_cend() const {
-    return by_size_const_iterator(Sizes.cend());
+    return by_size_const_iterator(current_sizes().cend());
   }
 
   bool operator==(const RangeSizeSet<T>& other) const {
@@ -404,9 +422,10 @@ public:
     std::size_t free_total = 0;
     if (begin() == end())
       return {free_total, 1.0};
+    update_size_index();
     for (auto iter = begin(); iter != end(); ++iter)
       free_total += calc_size(iter.from(), iter.to());
-    return {free_total, static_cast<double>(free_total - Sizes.begin()->first) / free_total};
+    return {free_total, static_cast<double>(free_total - Sizes.begin()->first.Size) / free_total};
   }
 
 private:
@@ -429,11 +448,35 @@ private:
   // - Stored ranges never overlap.
   MapT Map;
 
-  // The by-size multimap.
-  // Key is the size of the range.
+  // The by-size map.
+  // Key is the size and start of the range.
   // Value is a pointer to the range in the regular range map.
-  // We use std::greater so that Sizes.begin() gives us the largest range.
-  SizeMapT Sizes;
+  // Larger sizes sort first so that Sizes.begin() gives us the largest range, and ranges of equal size are sorted by
+  // address so that lookups by size always find the lowest one.
+  // In lazy mode this is only up to date if 'SizesDirty' is not set, and so is the 'SizeIt' of each range.
+  mutable SizeMapT Sizes;
+  bool LazySizes = false;
+  mutable bool SizesDirty = false;
+
+  // How to undo a single change made during a transaction.
+  enum class UndoAction {
+    // Erase the range starting at 'From', it was inserted.
+    Remove,
+    // Insert [From, To[ again, it was erased.
+    Restore,
+    // Set the end of the range starting at 'From' back to 'To'.
+    Resize,
+  };
+
+  struct UndoEntry {
+    UndoAction Action;
+    T From;
+    T To;
+  };
+
+  // Changes made since begin_transaction(), if 'InTransaction' is set.
+  std::vector<UndoEntry> UndoLog;
+  bool InTransaction = false;
 
   T get_from(typename MapT::iterator it) const {
     return it->first;
@@ -451,28 +494,193 @@ private:
     return it->second.To;
   }
 
-  typename MapT::iterator insert_range(T from, T to) {
-    auto m = Map.emplace(from, to).first;
-    m->second.SizeIt = Sizes.emplace(calc_size(from, to), m);
+  // Inserts [from, to[, where 'bound' is the first range that starts after 'from'. Returns the range containing it.
+  typename MapT::iterator insert_before(typename MapT::iterator bound, T from, T to) {
+    if (bound == Map.end()) {
+      // There is no range that starts greater than the given one.
+      // This means we have three options:
+      // - 1. No range exists yet, this is the first range.
+      if (Map.empty()) {
+        return insert_range(Map.end(), from, to);
+      }
+
+      // - 2. The given range does not overlap the last range.
+      --bound;
+      if (from > get_to(bound)) {
+        return insert_range(Map.end(), from, to);
+      }
+
+      // - 3. The given range does overlap the last range.
+      maybe_expand_to(bound, to);
+      return bound;
+    }
+
+    if (bound == Map.begin()) {
+      // The given range starts before any of the existing ones.
+      return insert_or_extend_down(bound, from, to);
+    }
+
+    auto abound = bound--;
+
+    // 'bound' now points at the first range in the map that
+    // could possibly be affected.
+
+    // If 'bound' overlaps with given range, update bounds object.
+    if (get_to(bound) >= from) {
+      maybe_expand_to(bound, to);
+      auto inserted = bound;
+      ++bound;
+      merge_from_iterator_to_value(inserted, bound, to);
+      return inserted;
+    }
+
+    // 'bound' *doesn't* overlap with given range, check next range.
+    return insert_or_extend_down(abound, from, to);
+  }
+
+  // Inserts [from, to[, where 'bound' is the first range that starts after 'from' and the range before it (if any) ends
+  // before 'from'. Returns the range containing it.
+  typename MapT::iterator insert_or_extend_down(typename MapT::iterator bound, T from, T to) {
+    // If 'bound' overlaps with given range, move its start down to 'from' in place and merge the overlaps into it.
+    if (get_from(bound) <= to) {
+      auto extended = move_from(bound, from);
+      maybe_expand_to(extended, to);
+      merge_from_iterator_to_value(extended, std::next(extended), to);
+      return extended;
+    }
+
+    // Otherwise, if we come here, then this new range overlaps nothing
+    // and must be inserted as a new range.
+    return insert_range(bound, from, to);
+  }
+
+  // Erases [from, to[, where 'bound' is the first range that starts after 'from'. Returns the first range starting at or
+  // after 'to'.
+  typename MapT::iterator erase_before(typename MapT::iterator bound, T from, T to) {
+    if (bound == Map.end()) {
+      // There is no range that starts greater than the given one.
+      if (Map.empty()) {
+        // nothing to do
+        return Map.end();
+      }
+      --bound;
+      // 'bound' now points at the last range.
+      if (from >= get_to(bound)) {
+        // Given range is larger than any range that exists, nothing to do.
+        return Map.end();
+      }
+
+      if (to >= get_to(bound)) {
+        if (from == get_from(bound)) {
+          // Given range fully overlaps last range, erase it.
+          return erase_range(bound);
+        } else {
+          // Given range overlaps end of last range, reduce it.
+          reduce_to(bound, from);
+          return Map.end();
+        }
+      }
+
+      if (from == get_from(bound)) {
+        // Given range overlaps begin of last range, reduce it.
+        return reduce_from(bound, to);
+      } else {
+        // Given range overlaps middle of last range, bisect it.
+        return bisect_range(bound, from, to);
+      }
+    }
+
+    if (bound == Map.begin()) {
+      // If we found the first range that means 'from' is before any stored range.
+      // This means we can just erase from start until 'to' and be done with it.
+      return erase_from_iterator_to_value(bound, to);
+    }
+
+    // check previous range
+    auto abound = bound--;
+
+    if (from == get_from(bound)) {
+      // Similarly, if the previous range starts with the given one, just erase until 'to'.
+      return erase_from_iterator_to_value(bound, to);
+    }
+
+    // If we come here, the given range may or may not overlap part of the current 'bound'
+    // (but never the full range), which means we may need to update the end position of it,
+    // or possibly even split it into two.
+    if (from < get_to(bound)) {
+      if (to < get_to(bound)) {
+        // need to split in two
+        return bisect_range(bound, from, to);
+      } else {
+        // just update end
+        reduce_to(bound, from);
+      }
+    }
+
+    // and then just erase until 'to'
+    return erase_from_iterator_to_value(abound, to);
+  }
+
+  // Returns what Map.upper_bound(from) would, using 'hint' instead if it is that range or the one before it.
+  typename MapT::iterator upper_bound_from_hint(typename MapT::const_iterator hint, T from) {
+    // Erasing an empty range is the usual way of turning a const_iterator into an iterator in constant time.
+    auto it = Map.erase(hint, hint);
+    if (it != Map.end() && get_from(it) <= from)
+      ++it;
+    if ((it == Map.end() || from < get_from(it)) && (it == Map.begin() || get_from(std::prev(it)) <= from))
+      return it;
+    return Map.upper_bound(from);
+  }
+
+  // The by-size map, brought up to date first if necessary.
+  const SizeMapT& current_sizes() const {
+    update_size_index();
+    return Sizes;
+  }
+
+  // Whether a change has to be applied to the by-size map right away. In lazy mode it is marked as outdated instead.
+  bool track_sizes() {
+    if (LazySizes) {
+      SizesDirty = true;
+      return false;
+    }
+    return true;
+  }
+
+  // 'hint' is the range the new one is inserted in front of.
+  typename MapT::iterator insert_range(typename MapT::const_iterator hint, T from, T to) {
+    if (InTransaction)
+      UndoLog.push_back({UndoAction::Remove, from, to});
+    auto m = Map.emplace_hint(hint, from, to);
+    if (track_sizes())
+      m->second.SizeIt = Sizes.emplace(SizeKey{calc_size(from, to), from}, m).first;
     return m;
   }
 
   typename MapT::iterator erase_range(typename MapT::iterator it) {
-    Sizes.erase(it->second.SizeIt);
+    if (InTransaction)
+      UndoLog.push_back({UndoAction::Restore, get_from(it), get_to(it)});
+    if (track_sizes())
+      Sizes.erase(it->second.SizeIt);
     return Map.erase(it);
   }
 
   typename MapT::const_iterator erase_range(typename MapT::const_iterator it) {
-    Sizes.erase(it->second.SizeIt);
+    if (InTransaction)
+      UndoLog.push_back({UndoAction::Restore, get_from(it), get_to(it)});
+    if (track_sizes())
+      Sizes.erase(it->second.SizeIt);
     return Map.erase(it);
   }
 
   typename SizeMapT::const_iterator erase_range_by_size(typename SizeMapT::const_iterator it) {
+    if (InTransaction)
+      UndoLog.push_back({UndoAction::Restore, get_from(it->second), get_to(it->second)});
     Map.erase(it->second);
     return Sizes.erase(it);
   }
 
-  void bisect_range(typename MapT::iterator it, T from, T to) {
+  typename MapT::iterator bisect_range(typename MapT::iterator it, T from, T to) {
     assert(get_from(it) < from);
     assert(get_from(it) < to);
     assert(get_to(it) > from);
@@ -480,14 +688,35 @@ private:
     assert(from < to);
     T itto = get_to(it);
     reduce_to(it, from);
-    insert_range(to, itto);
+    return insert_range(std::next(it), to, itto);
   }
 
   typename MapT::iterator reduce_from(typename MapT::iterator it, T from) {
     assert(get_from(it) < from);
-    T itto = get_to(it);
-    erase_range(it);
-    return insert_range(from, itto);
+    return move_from(it, from);
+  }
+
+  // Changes the start of the range 'it' to 'from', reusing its nodes in both maps. The range must stay between its
+  // neighbours.
+  typename MapT::iterator move_from(typename MapT::iterator it, T from) {
+    assert(from < get_to(it));
+    assert(it == Map.begin() || get_to(std::prev(it)) < from);
+    assert(std::next(it) == Map.end() || from < get_from(std::next(it)));
+    if (InTransaction) {
+      UndoLog.push_back({UndoAction::Restore, get_from(it), get_to(it)});
+      UndoLog.push_back({UndoAction::Remove, from, get_to(it)});
+    }
+    auto next = std::next(it);
+    auto node = Map.extract(it);
+    node.key() = from;
+    it = Map.insert(next, std::move(node));
+    if (track_sizes()) {
+      auto size_node = Sizes.extract(it->second.SizeIt);
+      size_node.key() = SizeKey{calc_size(from, get_to(it)), from};
+      size_node.mapped() = it;
+      it->second.SizeIt = Sizes.insert(std::move(size_node)).position;
+    }
+    return it;
   }
 
   void maybe_expand_to(typename MapT::iterator it, T to) {
@@ -499,16 +728,24 @@ private:
 
   void expand_to(typename MapT::iterator it, T to) {
     assert(get_to(it) < to);
+    if (InTransaction)
+      UndoLog.push_back({UndoAction::Resize, get_from(it), get_to(it)});
     it->second.To = to;
-    Sizes.erase(it->second.SizeIt);
-    it->second.SizeIt = Sizes.emplace(calc_size(get_from(it), to), it);
+    if (track_sizes()) {
+      Sizes.erase(it->second.SizeIt);
+      it->second.SizeIt = Sizes.emplace(SizeKey{calc_size(get_from(it), to), get_from(it)}, it).first;
+    }
   }
 
   void reduce_to(typename MapT::iterator it, T to) {
     assert(get_to(it) > to);
+    if (InTransaction)
+      UndoLog.push_back({UndoAction::Resize, get_from(it), get_to(it)});
     it->second.To = to;
-    Sizes.erase(it->second.SizeIt);
-    it->second.SizeIt = Sizes.emplace(calc_size(get_from(it), to), it);
+    if (track_sizes()) {
+      Sizes.erase(it->second.SizeIt);
+      it->second.SizeIt = Sizes.emplace(SizeKey{calc_size(get_from(it), to), get_from(it)}, it).first;
+    }
   }
 
   void merge_from_iterator_to_value(typename MapT::iterator inserted, typename MapT::iterator bound, T to) {
@@ -519,25 +756,23 @@ private:
     }
   }
 
-  void erase_from_iterator_to_value(typename MapT::iterator bound, T to) {
+  typename MapT::iterator erase_from_iterator_to_value(typename MapT::iterator bound, T to) {
     // Assumption: Given bound starts at or after the 'from' value of the range to erase.
     while (true) {
       // Given range starts before stored range.
       if (to <= get_from(bound)) {
         // Range ends before this range too, nothing to do.
-        return;
+        return bound;
       }
 
       if (to < get_to(bound)) {
         // Range ends in the middle of current range, reduce current.
-        reduce_from(bound, to);
-        return;
+        return reduce_from(bound, to);
       }
 
       if (to == get_to(bound)) {
         // Range ends exactly with current range, erase current.
-        erase_range(bound);
-        return;
+        return erase_range(bound);
       }
 
       // Range ends later than current range.
@@ -545,7 +780,7 @@ private:
       bound = erase_range(bound);
       if (bound == Map.end()) {
         // Unless that was the last range, in which case there's nothing else to do.
-        return;
+        return bound;
       }
     }
   }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "rangeset.h"
+#include "staticrangeset.h"
+
+namespace HyoutaUtilities {
+// Like RangeSet, but stores up to K ranges inline in the object itself and only switches to the std::map based
+// RangeSet once more ranges are needed. Once the number of ranges drops to K / 2 or below it switches back, so a set
+// that hovers around K ranges doesn't constantly move its ranges back and forth.
+template <typename T, std::size_t K = 8> class SmallRangeSet {
+private:
+  using InlineT = StaticRangeSet<T, K>;
+  using TreeT = RangeSet<T>;
+
+public:
+  struct const_iterator {
+  public:
+    const T& from() const {
+      return IsTree ? TreeIt.from() : InlineIt.from();
+    }
+
+    const T& to() const {
+      return IsTree ? TreeIt.to() : InlineIt.to();
+    }
+
+    const_iterator& operator++() {
+      if (IsTree)
+        ++TreeIt;
+      else
+        ++InlineIt;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      operator++();
+      return old;
+    }
+
+    const_iterator& operator--() {
+      if (IsTree)
+        --TreeIt;
+      else
+        --InlineIt;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      operator--();
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const {
+      return this->IsTree == rhs.IsTree && (IsTree ? this->TreeIt == rhs.TreeIt : this->InlineIt == rhs.InlineIt);
+    }
+
+    bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    // Only one of these is meaningful, depending on 'IsTree'.
+    typename InlineT::const_iterator InlineIt;
+    typename TreeT::const_iterator TreeIt;
+    bool IsTree;
+    const_iterator(typename InlineT::const_iterator inlineIt, typename TreeT::const_iterator treeIt, bool isTree)
+        : InlineIt(inlineIt), TreeIt(treeIt), IsTree(isTree) {}
+    friend class SmallRangeSet;
+  };
+
+  void insert(T from, T to) {
+    if (!UsingTree) {
+      if (Inline.insert(from, to))
+        return;
+      move_to_tree();
+    }
+    Tree.insert(from, to);
+  }
+
+  void erase(T from, T to) {
+    if (!UsingTree) {
+      if (Inline.erase(from, to))
+        return;
+      move_to_tree();
+    }
+    Tree.erase(from, to);
+    maybe_move_to_inline();
+  }
+
+  const_iterator erase(const_iterator it) {
+    if (!UsingTree)
+      return make_iterator(Inline.erase(it.InlineIt), Tree.end());
+
+    auto next = Tree.erase(it.TreeIt);
+    if (Tree.size() > K / 2)
+      return make_iterator(Inline.end(), next);
+
+    // We're about to switch representations, so remember where 'next' was to find it again afterwards.
+    const bool next_is_end = next == Tree.end();
+    const T next_from = next_is_end ? T() : next.from();
+    maybe_move_to_inline();
+    if (next_is_end)
+      return end();
+    auto inline_it = Inline.begin();
+    while (inline_it.from() != next_from)
+      ++inline_it;
+    return make_iterator(inline_it, Tree.end());
+  }
+
+  void clear() {
+    Inline.clear();
+    Tree.clear();
+    UsingTree = false;
+  }
+
+  bool contains(T value) const {
+    return UsingTree ? Tree.contains(value) : Inline.contains(value);
+  }
+
+  std::size_t size() const {
+    return UsingTree ? Tree.size() : Inline.size();
+  }
+
+  bool empty() const {
+    return UsingTree ? Tree.empty() : Inline.empty();
+  }
+
+  // Returns true if the ranges are currently stored in the std::map instead of inline.
+  bool is_tree() const {
+    return UsingTree;
+  }
+
+  void swap(SmallRangeSet<T, K>& other) {
+    Inline.swap(other.Inline);
+    Tree.swap(other.Tree);
+    std::swap(UsingTree, other.UsingTree);
+  }
+
+  const_iterator begin() const {
+    return make_iterator(Inline.begin(), Tree.begin());
+  }
+
+  const_iterator end() const {
+    return make_iterator(Inline.end(), Tree.end());
+  }
+
+  const_iterator cbegin() const {
+    return make_iterator(Inline.cbegin(), Tree.cbegin());
+  }
+
+  const_iterator cend() const {
+    return make_iterator(Inline.cend(), Tree.cend());
+  }
+
+  bool operator==(const SmallRangeSet<T, K>& other) const {
+    // The two sets may be in different representations, so compare range by range.
+    if (this->size() != other.size())
+      return false;
+    for (auto a = this->begin(), b = other.begin(); a != this->end(); ++a, ++b) {
+      if (a.from() != b.from() || a.to() != b.to())
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const SmallRangeSet<T, K>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    return UsingTree ? Tree.get_stats() : Inline.get_stats();
+  }
+
+private:
+  // Ranges are stored in exactly one of these, depending on 'UsingTree'. The other one is always empty.
+  InlineT Inline;
+  TreeT Tree;
+  bool UsingTree = false;
+
+  const_iterator make_iterator(typename InlineT::const_iterator inlineIt,
+                               typename TreeT::const_iterator treeIt) const {
+    return const_iterator(inlineIt, treeIt, UsingTree);
+  }
+
+  void move_to_tree() {
+    for (auto it = Inline.begin(); it != Inline.end(); ++it)
+      Tree.insert(it.from(), it.to());
+    Inline.clear();
+    UsingTree = true;
+  }
+
+  void maybe_move_to_inline() {
+    if (Tree.size() > K / 2)
+      return;
+    for (auto it = Tree.begin(); it != Tree.end(); ++it)
+      Inline.insert(it.from(), it.to());
+    Tree.clear();
+    UsingTree = false;
+  }
+};
+} // namespace HyoutaUtilities
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+namespace HyoutaUtilities {
+// Like RangeSet, but stores up to N ranges inline in a sorted array instead of in a std::map, so it never allocates.
+// All operations that don't need pointer arithmetic are constexpr, so this can also be used to build tables at
+// compile time.
+// Operations that would need more than N ranges fail and leave the set unchanged; this is reported through their
+// return value.
+template <typename T, std::size_t N> class StaticRangeSet {
+  static_assert(N > 0, "StaticRangeSet needs room for at least one range.");
+
+private:
+  struct Range {
+    T From{};
+    T To{};
+  };
+
+public:
+  struct const_iterator {
+  public:
+    constexpr const T& from() const {
+      return Ptr->From;
+    }
+
+    constexpr const T& to() const {
+      return Ptr->To;
+    }
+
+    constexpr const_iterator& operator++() {
+      ++Ptr;
+      return *this;
+    }
+
+    constexpr const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++Ptr;
+      return old;
+    }
+
+    constexpr const_iterator& operator--() {
+      --Ptr;
+      return *this;
+    }
+
+    constexpr const_iterator operator--(int) {
+      const_iterator old = *this;
+      --Ptr;
+      return old;
+    }
+
+    constexpr bool operator==(const const_iterator& rhs) const {
+      return this->Ptr == rhs.Ptr;
+    }
+
+    constexpr bool operator!=(const const_iterator& rhs) const {
+      return !operator==(rhs);
+    }
+
+  private:
+    const Range* Ptr;
+    constexpr const_iterator(const Range* ptr) : Ptr(ptr) {}
+    friend class StaticRangeSet;
+  };
+
+  constexpr StaticRangeSet() = default;
+
+  // Inserts all given ranges, with the same merging behavior as insert().
+  // The ranges must fit into the set, which makes this a compile error when used in a constant expression.
+  constexpr StaticRangeSet(std::initializer_list<std::pair<T, T>> ranges) {
+    for (const auto& range : ranges) {
+      const bool inserted = insert(range.first, range.second);
+      assert(inserted);
+      (void)inserted;
+    }
+  }
+
+  // Returns false if the range could not be inserted because the set is full.
+  constexpr bool insert(T from, T to) {
+    if (from >= to)
+      return true;
+
+    // All ranges in [first, last[ overlap or touch the given range and will be merged into one.
+    // 'first' is the first range that ends at or after 'from',
+    // 'last' is the first range that starts after 'to'.
+    std::size_t first = first_ending_at_or_after(from);
+    std::size_t last = first_starting_after(to);
+
+    if (first == last) {
+      // Overlaps nothing, must be inserted as a new range.
+      if (Count == N)
+        return false;
+      open_gap(first, 1);
+      Ranges[first].From = from;
+      Ranges[first].To = to;
+      return true;
+    }
+
+    if (Ranges[first].From < from)
+      from = Ranges[first].From;
+    if (Ranges[last - 1].To > to)
+      to = Ranges[last - 1].To;
+    Ranges[first].From = from;
+    Ranges[first].To = to;
+    close_gap(first + 1, last - first - 1);
+    return true;
+  }
+
+  // Returns false if the range could not be erased because it would split a range and the set is full.
+  constexpr bool erase(T from, T to) {
+    if (from >= to)
+      return true;
+
+    // All ranges in [first, last[ overlap the given range and will be reduced or removed.
+    // 'first' is the first range that ends after 'from',
+    // 'last' is the first range that starts at or after 'to'.
+    std::size_t first = first_ending_after(from);
+    std::size_t last = first_starting_at_or_after(to);
+    if (first == last)
+      return true;
+
+    const bool keep_head = Ranges[first].From < from;
+    const bool keep_tail = Ranges[last - 1].To > to;
+    const std::size_t affected = last - first;
+    const std::size_t remaining = (keep_head ? 1 : 0) + (keep_tail ? 1 : 0);
+    if (remaining > affected) {
+      // Given range overlaps middle of a single range, bisect it.
+      if (Count == N)
+        return false;
+      open_gap(first + 1, 1);
+      Ranges[first + 1].From = to;
+      Ranges[first + 1].To = Ranges[first].To;
+      Ranges[first].To = from;
+      return true;
+    }
+
+    const T tail_to = Ranges[last - 1].To;
+    std::size_t out = first;
+    if (keep_head) {
+      Ranges[out].To = from;
+      ++out;
+    }
+    if (keep_tail) {
+      Ranges[out].From = to;
+      Ranges[out].To = tail_to;
+      ++out;
+    }
+    close_gap(out, affected - remaining);
+    return true;
+  }
+
+  constexpr const_iterator erase(const_iterator it) {
+    const std::size_t index = static_cast<std::size_t>(it.Ptr - Ranges.data());
+    close_gap(index, 1);
+    return const_iterator(Ranges.data() + index);
+  }
+
+  constexpr void clear() {
+    Count = 0;
+  }
+
+  constexpr bool contains(T value) const {
+    std::size_t index = first_ending_after(value);
+    return index != Count && Ranges[index].From <= value;
+  }
+
+  // Returns the range that contains the given value, or end() if there is none.
+  constexpr const_iterator find(T value) const {
+    std::size_t index = first_ending_after(value);
+    if (index != Count && Ranges[index].From <= value)
+      return const_iterator(Ranges.data() + index);
+    return end();
+  }
+
+  constexpr std::size_t size() const {
+    return Count;
+  }
+
+  constexpr bool empty() const {
+    return Count == 0;
+  }
+
+  constexpr bool full() const {
+    return Count == N;
+  }
+
+  static constexpr std::size_t capacity() {
+    return N;
+  }
+
+  // Returns a copy of this set with a different capacity, which must be large enough to hold all ranges.
+  // Mostly useful for building a table in a generously sized set in a constant expression and then storing only as
+  // many ranges as were actually needed in the binary, eg.
+  // constexpr auto builder = StaticRangeSet<uint32_t, 64>{{0x1000, 0x2000}, {0x8000, 0x9000}};
+  // constexpr auto table = builder.with_capacity<builder.size()>();
+  template <std::size_t M> constexpr StaticRangeSet<T, M> with_capacity() const {
+    assert(Count <= M);
+    StaticRangeSet<T, M> result;
+    for (std::size_t i = 0; i < Count; ++i)
+      result.Ranges[i] = typename StaticRangeSet<T, M>::Range{Ranges[i].From, Ranges[i].To};
+    result.Count = Count;
+    return result;
+  }
+
+  constexpr void swap(StaticRangeSet<T, N>& other) {
+    for (std::size_t i = 0; i < N; ++i) {
+      Range tmp = Ranges[i];
+      Ranges[i] = other.Ranges[i];
+      other.Ranges[i] = tmp;
+    }
+    std::size_t tmp = Count;
+    Count = other.Count;
+    other.Count = tmp;
+  }
+
+  constexpr const_iterator begin() const {
+    return const_iterator(Ranges.data());
+  }
+
+  constexpr const_iterator end() const {
+    return const_iterator(Ranges.data() + Count);
+  }
+
+  constexpr const_iterator cbegin() const {
+    return const_iterator(Ranges.data());
+  }
+
+  constexpr const_iterator cend() const {
+    return const_iterator(Ranges.data() + Count);
+  }
+
+  constexpr bool operator==(const StaticRangeSet<T, N>& other) const {
+    if (this->Count != other.Count)
+      return false;
+    for (std::size_t i = 0; i < Count; ++i) {
+      if (this->Ranges[i].From != other.Ranges[i].From || this->Ranges[i].To != other.Ranges[i].To)
+        return false;
+    }
+    return true;
+  }
+
+  constexpr bool operator!=(const StaticRangeSet<T, N>& other) const {
+    return !(*this == other);
+  }
+
+  // Get free size and fragmentation ratio
+  std::pair<std::size_t, double> get_stats() const {
+    std::size_t free_total = 0;
+    if (begin() == end())
+      return {free_total, 1.0};
+    std::size_t largest_size = 0;
+    for (auto iter = begin(); iter != end(); ++iter) {
+      const std::size_t size = calc_size(iter.from(), iter.to());
+      if (size > largest_size)
+        largest_size = size;
+      free_total += size;
+    }
+    return {free_total, static_cast<double>(free_total - largest_size) / free_total};
+  }
+
+private:
+  static std::size_t calc_size(T from, T to) {
+    if constexpr (std::is_pointer_v<T>) {
+      // For pointers we don't want pointer arithmetic here, else void* breaks.
+      return reinterpret_cast<std::size_t>(to) - reinterpret_cast<std::size_t>(from);
+    } else {
+      return static_cast<std::size_t>(to - from);
+    }
+  }
+
+  // Assumptions that can be made about the data:
+  // - Range are stored in the form [from, to[
+  //   That is, the starting value is inclusive, and the end value is exclusive.
+  // - Only the first 'Count' entries of 'Ranges' are in use, sorted by their starting value.
+  // - 'from' is always smaller than 'to'
+  // - Stored ranges never touch.
+  // - Stored ranges never overlap.
+  // Since ranges never overlap, both the 'from' and the 'to' values are sorted, so we can binary search either.
+  std::array<Range, N> Ranges{};
+  std::size_t Count = 0;
+
+  template <typename U, std::size_t M> friend class StaticRangeSet;
+
+  constexpr std::size_t first_ending_after(T value) const {
+    std::size_t lo = 0;
+    std::size_t hi = Count;
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      if (Ranges[mid].To <= value)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  constexpr std::size_t first_ending_at_or_after(T value) const {
+    std::size_t lo = 0;
+    std::size_t hi = Count;
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      if (Ranges[mid].To < value)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  constexpr std::size_t first_starting_after(T value) const {
+    std::size_t lo = 0;
+    std::size_t hi = Count;
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      if (Ranges[mid].From <= value)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  constexpr std::size_t first_starting_at_or_after(T value) const {
+    std::size_t lo = 0;
+    std::size_t hi = Count;
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      if (Ranges[mid].From < value)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  // Shifts all ranges starting at 'index' up by 'amount' entries.
+  constexpr void open_gap(std::size_t index, std::size_t amount) {
+    assert(Count + amount <= N);
+    for (std::size_t i = Count; i > index; --i)
+      Ranges[i - 1 + amount] = Ranges[i - 1];
+    Count += amount;
+  }
+
+  // Removes 'amount' entries starting at 'index' by shifting all ranges after them down.
+  constexpr void close_gap(std::size_t index, std::size_t amount) {
+    if (amount == 0)
+      return;
+    assert(index + amount <= Count);
+    for (std::size_t i = index + amount; i < Count; ++i)
+      Ranges[i - amount] = Ranges[i];
+    Count -= amount;
+  }
+};
+} // namespace HyoutaUtilities
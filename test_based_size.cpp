@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+
+#include "basedrangesizeset.h"
+
+TEST(BasedSizeTest, VoidPointer) {
+  std::array<uint32_t, 20> arr;
+  HyoutaUtilities::BasedRangeSizeSet<void*> rs(&arr[0]);
+  rs.insert(&arr[7], &arr[8]);
+  rs.insert(&arr[0], &arr[2]);
+  rs.insert(&arr[15], &arr[19]);
+  rs.insert(&arr[11], &arr[14]);
+  rs.insert(&arr[14], &arr[15]);
+
+  auto it = rs.begin();
+  ASSERT_TRUE(it != rs.end());
+  ASSERT_TRUE(it.from() == &arr[0]);
+  ASSERT_TRUE(it.to() == &arr[2]);
+  ++it;
+  ASSERT_TRUE(it != rs.end());
+  ASSERT_TRUE(it.from() == &arr[7]);
+  ASSERT_TRUE(it.to() == &arr[8]);
+  ++it;
+  ASSERT_TRUE(it != rs.end());
+  ASSERT_TRUE(it.from() == &arr[11]);
+  ASSERT_TRUE(it.to() == &arr[19]);
+  ++it;
+  ASSERT_TRUE(it == rs.end());
+
+  auto sit = rs.by_size_begin();
+  ASSERT_TRUE(sit != rs.by_size_end());
+  ASSERT_TRUE(sit.from() == &arr[11]);
+  ASSERT_TRUE(sit.to() == &arr[19]);
+  ASSERT_TRUE(sit.to_range_iterator().from() == &arr[11]);
+  ++sit;
+  ASSERT_TRUE(sit != rs.by_size_end());
+  ASSERT_TRUE(sit.from() == &arr[0]);
+  ASSERT_TRUE(sit.to() == &arr[2]);
+  ++sit;
+  ASSERT_TRUE(sit != rs.by_size_end());
+  ASSERT_TRUE(sit.from() == &arr[7]);
+  ASSERT_TRUE(sit.to() == &arr[8]);
+  ++sit;
+  ASSERT_TRUE(sit == rs.by_size_end());
+
+  // Sizes are in bytes, like in RangeSizeSet<void*>.
+  EXPECT_TRUE(rs.by_size_count(8 * sizeof(uint32_t)) == 1);
+  EXPECT_TRUE(rs.by_size_find(2 * sizeof(uint32_t)).from() == &arr[0]);
+
+  EXPECT_TRUE(rs.contains(&arr[1]));
+  EXPECT_FALSE(rs.contains(&arr[2]));
+  EXPECT_TRUE(rs.contains(&arr[14]));
+
+  rs.erase(&arr[12], &arr[13]);
+  ASSERT_TRUE(rs.size() == 4);
+  EXPECT_FALSE(rs.contains(&arr[12]));
+  EXPECT_TRUE(rs.contains(&arr[13]));
+}
+
+TEST(BasedSizeTest, SmallOffsets) {
+  const uint64_t base = 0x7fff'0000'0000;
+  HyoutaUtilities::BasedRangeSizeSet<uint64_t, uint16_t> rs(base);
+  rs.insert(base + 0x100, base + 0x200);
+  rs.insert(base + 0x8000, base + 0xffff);
+  rs.insert(base, base + 0x10);
+
+  EXPECT_FALSE(rs.contains(base - 1));
+  EXPECT_TRUE(rs.contains(base));
+  EXPECT_TRUE(rs.contains(base + 0x1ff));
+  EXPECT_FALSE(rs.contains(base + 0x200));
+  EXPECT_TRUE(rs.contains(base + 0xfffe));
+  EXPECT_FALSE(rs.contains(base + 0xffff));
+  EXPECT_FALSE(rs.contains(base + 0x10000));
+
+  EXPECT_TRUE(rs.by_size_begin().from() == base + 0x8000);
+  EXPECT_TRUE(rs.by_size_begin().to() == base + 0xffff);
+  EXPECT_TRUE((--rs.end()).from() == base + 0x8000);
+}
+
+TEST(BasedSizeTest, EqualityAcrossBases) {
+  HyoutaUtilities::BasedRangeSizeSet<uint64_t> rs1(1000);
+  HyoutaUtilities::BasedRangeSizeSet<uint64_t> rs2(2000);
+  rs1.insert(3000, 3100);
+  rs2.insert(3000, 3100);
+  EXPECT_TRUE(rs1 == rs2);
+  rs2.insert(4000, 4100);
+  EXPECT_TRUE(rs1 != rs2);
+
+  rs1.swap(rs2);
+  EXPECT_TRUE(rs1.base() == 2000);
+  EXPECT_TRUE(rs1.size() == 2);
+  EXPECT_TRUE(rs2.base() == 1000);
+  EXPECT_TRUE(rs2.size() == 1);
+}
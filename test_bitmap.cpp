@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "bitmaprangeset.h"
+#include "rangeset.h"
+
+using Bitmap = HyoutaUtilities::BitmapRangeSet<std::size_t>;
+
+static bool same(const Bitmap& bs, const HyoutaUtilities::RangeSet<std::size_t>& rs) {
+  if (bs.size() != rs.size())
+    return false;
+  auto it = rs.begin();
+  for (auto bit = bs.begin(); bit != bs.end(); ++bit, ++it) {
+    if (it == rs.end() || bit.from() != it.from() || bit.to() != it.to())
+      return false;
+  }
+  if (it != rs.end())
+    return false;
+
+  // And the same backwards.
+  auto bit = bs.end();
+  it = rs.end();
+  while (it != rs.begin()) {
+    --bit;
+    --it;
+    if (bit.from() != it.from() || bit.to() != it.to())
+      return false;
+  }
+  return bit == bs.begin();
+}
+
+TEST(BitmapTest, Basics) {
+  Bitmap bs(1000);
+  EXPECT_TRUE(bs.empty());
+  EXPECT_TRUE(bs.begin() == bs.end());
+  bs.insert(10, 20);
+  bs.insert(20, 30);
+  bs.insert(100, 900);
+  bs.insert(990, 1000);
+  ASSERT_TRUE(bs.size() == 3);
+  EXPECT_TRUE(bs.contains(10));
+  EXPECT_TRUE(bs.contains(29));
+  EXPECT_FALSE(bs.contains(30));
+  EXPECT_TRUE(bs.contains(999));
+  EXPECT_FALSE(bs.contains(1000));
+  EXPECT_TRUE(bs.find(500).from() == 100);
+  EXPECT_TRUE(bs.find(500).to() == 900);
+  EXPECT_TRUE(bs.find(50) == bs.end());
+
+  auto it = bs.end();
+  --it;
+  EXPECT_TRUE(it.from() == 990);
+  EXPECT_TRUE(it.to() == 1000);
+
+  bs.erase(150, 160);
+  ASSERT_TRUE(bs.size() == 4);
+  it = bs.erase(bs.find(10));
+  EXPECT_TRUE(it.from() == 100);
+  ASSERT_TRUE(bs.size() == 3);
+}
+
+TEST(BitmapTest, ClampsToLimit) {
+  Bitmap bs(1000);
+  bs.insert(990, 5000);
+  bs.insert(2000, 3000);
+  ASSERT_TRUE(bs.size() == 1);
+  EXPECT_TRUE(bs.begin().from() == 990);
+  EXPECT_TRUE(bs.begin().to() == 1000);
+  EXPECT_FALSE(bs.contains(1000));
+  bs.erase(995, 5000);
+  EXPECT_TRUE(bs.begin().to() == 995);
+  EXPECT_TRUE(bs.get_stats().first == 5);
+}
+
+TEST(BitmapTest, FindFree) {
+  Bitmap bs(1 << 20);
+  bs.insert(0, 1 << 20);
+  EXPECT_TRUE(bs.find_free(1) == bs.limit());
+  bs.erase(5000, 5003);
+  bs.erase(700000, 700100);
+  bs.erase((1 << 20) - 10, 1 << 20);
+  EXPECT_TRUE(bs.find_free(1) == 5000);
+  EXPECT_TRUE(bs.find_free(3) == 5000);
+  EXPECT_TRUE(bs.find_free(4) == 700000);
+  EXPECT_TRUE(bs.find_free(100) == 700000);
+  EXPECT_TRUE(bs.find_free(101) == bs.limit());
+  bs.clear();
+  EXPECT_TRUE(bs.find_free(1 << 20) == 0);
+}
+
+TEST(BitmapTest, MatchesRangeSet) {
+  constexpr std::size_t Limit = 5000;
+  Bitmap bs(Limit);
+  HyoutaUtilities::RangeSet<std::size_t> rs;
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<std::size_t> dist(0, Limit);
+  for (int i = 0; i < 3000; ++i) {
+    std::size_t a = dist(rng);
+    std::size_t b = dist(rng);
+    if (a > b)
+      std::swap(a, b);
+    if (i % 10 != 0)
+      b = std::min(a + rng() % 200, Limit);
+    if (rng() % 2 == 0) {
+      bs.insert(a, b);
+      rs.insert(a, b);
+    } else {
+      bs.erase(a, b);
+      rs.erase(a, b);
+    }
+    ASSERT_TRUE(same(bs, rs));
+
+    std::size_t n = 1 + rng() % 100;
+    std::size_t expected = Limit;
+    std::size_t prev_end = 0;
+    for (auto it = rs.begin(); it != rs.end(); ++it) {
+      if (it.from() - prev_end >= n) {
+        expected = prev_end;
+        break;
+      }
+      prev_end = it.to();
+    }
+    if (expected == Limit && Limit - prev_end >= n)
+      expected = prev_end;
+    ASSERT_TRUE(bs.find_free(n) == expected);
+  }
+}
+
+TEST(BitmapTest, Bounds) {
+  Bitmap bs(200);
+  bs.insert(0, 10);
+  bs.insert(64, 130);
+  bs.insert(190, 200);
+  EXPECT_TRUE(bs.lower_bound(0).from() == 0);
+  EXPECT_TRUE(bs.lower_bound(1).from() == 64);
+  EXPECT_TRUE(bs.lower_bound(64).from() == 64);
+  EXPECT_TRUE(bs.lower_bound(65).from() == 190);
+  EXPECT_TRUE(bs.lower_bound(191) == bs.end());
+  EXPECT_TRUE(bs.lower_bound(500) == bs.end());
+  EXPECT_TRUE(bs.upper_bound(0).from() == 64);
+  EXPECT_TRUE(bs.upper_bound(63).from() == 64);
+  EXPECT_TRUE(bs.upper_bound(64).from() == 190);
+  EXPECT_TRUE(bs.upper_bound(190) == bs.end());
+  EXPECT_TRUE(bs.upper_bound(199) == bs.end());
+  EXPECT_TRUE(bs.upper_bound(~std::size_t(0)) == bs.end());
+}
+
+TEST(BitmapTest, BoundsMatchRangeSet) {
+  constexpr std::size_t Limit = 3000;
+  Bitmap bs(Limit);
+  HyoutaUtilities::RangeSet<std::size_t> rs;
+  std::mt19937 rng(34);
+  std::uniform_int_distribution<std::size_t> point(0, Limit - 1);
+  for (int i = 0; i < 500; ++i) {
+    const std::size_t from = point(rng);
+    const std::size_t to = std::min(from + 1 + rng() % 150, Limit);
+    if (rng() % 3 == 0) {
+      bs.erase(from, to);
+      rs.erase(from, to);
+    } else {
+      bs.insert(from, to);
+      rs.insert(from, to);
+    }
+    for (int j = 0; j < 20; ++j) {
+      const std::size_t value = point(rng);
+      const auto lower = bs.lower_bound(value);
+      const auto expected_lower = rs.lower_bound(value);
+      ASSERT_TRUE((lower == bs.end()) == (expected_lower == rs.end()));
+      if (lower != bs.end()) {
+        ASSERT_TRUE(lower.from() == expected_lower.from() && lower.to() == expected_lower.to());
+      }
+      const auto upper = bs.upper_bound(value);
+      const auto expected_upper = rs.upper_bound(value);
+      ASSERT_TRUE((upper == bs.end()) == (expected_upper == rs.end()));
+      if (upper != bs.end()) {
+        ASSERT_TRUE(upper.from() == expected_upper.from() && upper.to() == expected_upper.to());
+      }
+    }
+  }
+}
@@ -76,3 +76,22 @@ TEST(ContainsTest, Tests) {
   EXPECT_FALSE(rs.contains(59));
   EXPECT_FALSE(rs.contains(60));
 }
+
+TEST(ContainsTest, Find) {
+  HyoutaUtilities::RangeSet<std::size_t> rs;
+  setup(rs);
+  EXPECT_TRUE(rs.find(9) == rs.end());
+  EXPECT_TRUE(rs.find(10) == rs.begin());
+  EXPECT_TRUE(rs.find(17) == rs.begin());
+  EXPECT_TRUE(rs.find(18) == rs.end());
+  EXPECT_TRUE(rs.find(40).from() == 40);
+  EXPECT_TRUE(rs.find(41) == rs.end());
+  EXPECT_TRUE(rs.find(55).to() == 56);
+
+  EXPECT_TRUE(rs.lower_bound(10) == rs.begin());
+  EXPECT_TRUE(rs.lower_bound(11).from() == 20);
+  EXPECT_TRUE(rs.upper_bound(10).from() == 20);
+  EXPECT_TRUE(rs.upper_bound(9) == rs.begin());
+  EXPECT_TRUE(rs.lower_bound(51) == rs.end());
+  EXPECT_TRUE(rs.upper_bound(50) == rs.end());
+}
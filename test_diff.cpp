@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangeset.h"
+
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+TEST(DiffTest, AddedAndRemovedParts) {
+  HyoutaUtilities::RangeSet<uint32_t> a;
+  HyoutaUtilities::RangeSet<uint32_t> b;
+  a.insert(0, 10);
+  a.insert(20, 30);
+  a.insert(40, 50);
+  a.insert(60, 70);
+  b.insert(0, 10);
+  b.insert(15, 25);
+  b.insert(40, 45);
+  b.insert(47, 55);
+  b.insert(80, 90);
+
+  Ranges added;
+  Ranges removed;
+  HyoutaUtilities::diff(a, b, std::back_inserter(added), std::back_inserter(removed));
+  EXPECT_TRUE(added == Ranges({{15, 20}, {50, 55}, {80, 90}}));
+  EXPECT_TRUE(removed == Ranges({{25, 30}, {45, 47}, {60, 70}}));
+
+  added.clear();
+  removed.clear();
+  HyoutaUtilities::diff(a, a, std::back_inserter(added), std::back_inserter(removed));
+  EXPECT_TRUE(added.empty());
+  EXPECT_TRUE(removed.empty());
+}
+
+TEST(DiffTest, ApplyingDiffGivesTarget) {
+  std::mt19937 rng(39);
+  std::uniform_int_distribution<uint32_t> point(0, 1000);
+  std::uniform_int_distribution<uint32_t> length(1, 40);
+  HyoutaUtilities::RangeSet<uint32_t> a;
+  for (int round = 0; round < 500; ++round) {
+    HyoutaUtilities::RangeSet<uint32_t> b = a;
+    for (int i = 0; i < 5; ++i) {
+      const uint32_t from = point(rng);
+      const uint32_t to = from + length(rng);
+      if (rng() % 2 == 0)
+        b.erase(from, to);
+      else
+        b.insert(from, to);
+    }
+
+    Ranges added;
+    Ranges removed;
+    HyoutaUtilities::diff(a, b, std::back_inserter(added), std::back_inserter(removed));
+    for (const auto& range : added) {
+      EXPECT_FALSE(a.contains(range.first));
+      EXPECT_TRUE(b.contains(range.first));
+    }
+    for (const auto& range : removed) {
+      EXPECT_TRUE(a.contains(range.first));
+      EXPECT_FALSE(b.contains(range.first));
+    }
+
+    for (const auto& range : removed)
+      a.erase(range.first, range.second);
+    for (const auto& range : added)
+      a.insert(range.first, range.second);
+    ASSERT_TRUE(a == b);
+  }
+}
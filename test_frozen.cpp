@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "frozenrangeset.h"
+#include "rangeset.h"
+
+static bool same(const HyoutaUtilities::FrozenRangeSet<uint32_t>& fs, const HyoutaUtilities::RangeSet<uint32_t>& rs) {
+  if (fs.size() != rs.size())
+    return false;
+  auto it = rs.begin();
+  for (auto fit = fs.begin(); fit != fs.end(); ++fit, ++it) {
+    if (it == rs.end() || fit.from() != it.from() || fit.to() != it.to())
+      return false;
+  }
+  if (it != rs.end())
+    return false;
+
+  // And the same backwards.
+  auto fit = fs.end();
+  for (auto rit = rs.end(); rit != rs.begin();) {
+    --rit;
+    --fit;
+    if (fit.from() != rit.from() || fit.to() != rit.to())
+      return false;
+  }
+  return fit == fs.begin();
+}
+
+TEST(FrozenTest, Empty) {
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  auto fs = HyoutaUtilities::freeze(rs);
+  EXPECT_TRUE(fs.empty());
+  EXPECT_TRUE(fs.begin() == fs.end());
+  EXPECT_FALSE(fs.contains(0));
+  EXPECT_TRUE(fs.find(0) == fs.end());
+  EXPECT_TRUE(fs.get_stats() == rs.get_stats());
+}
+
+TEST(FrozenTest, MatchesRangeSet) {
+  std::mt19937 rng(45);
+  std::uniform_int_distribution<uint32_t> length(1, 20);
+  for (std::size_t count : {1, 2, 3, 7, 8, 100, 1000, 4097}) {
+    HyoutaUtilities::RangeSet<uint32_t> rs;
+    uint32_t pos = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      pos += length(rng);
+      const uint32_t to = pos + length(rng);
+      rs.insert(pos, to);
+      pos = to;
+    }
+    ASSERT_TRUE(rs.size() == count);
+
+    const auto fs = HyoutaUtilities::freeze(rs);
+    ASSERT_TRUE(same(fs, rs));
+    EXPECT_TRUE(fs.get_stats() == rs.get_stats());
+    for (uint32_t value = 0; value < pos + 5; ++value) {
+      ASSERT_TRUE(fs.contains(value) == rs.contains(value));
+      const auto found = fs.find(value);
+      const auto expected = rs.find(value);
+      if (expected == rs.end()) {
+        ASSERT_TRUE(found == fs.end());
+      } else {
+        ASSERT_TRUE(found.from() == expected.from() && found.to() == expected.to());
+      }
+    }
+    EXPECT_TRUE(fs == HyoutaUtilities::freeze(rs));
+  }
+}
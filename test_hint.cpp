@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "radixrangeset.h"
+#include "rangeset.h"
+#include "rangesizeset.h"
+
+template <typename Set> static typename Set::const_iterator pick_hint(const Set& rs, std::mt19937& rng) {
+  // Mostly garbage hints, the result has to be correct regardless.
+  auto it = rs.begin();
+  for (uint32_t steps = rng() % 8; steps > 0 && it != rs.end(); --steps)
+    ++it;
+  return it;
+}
+
+TEST(HintTest, AscendingInsertChain) {
+  HyoutaUtilities::RangeSet<uint32_t> hinted;
+  HyoutaUtilities::RangeSet<uint32_t> plain;
+  auto hint = hinted.end();
+  for (uint32_t i = 0; i < 1000; ++i) {
+    hint = hinted.insert(hint, i * 10, i * 10 + 5 + (i % 3) * 3);
+    plain.insert(i * 10, i * 10 + 5 + (i % 3) * 3);
+    ASSERT_TRUE(hint.from() <= i * 10 && i * 10 + 5 <= hint.to());
+  }
+  EXPECT_TRUE(hinted == plain);
+
+  hint = hinted.begin();
+  for (uint32_t i = 0; i < 1000; i += 2) {
+    hint = hinted.erase(hint, i * 10 + 1, i * 10 + 12);
+    plain.erase(i * 10 + 1, i * 10 + 12);
+    ASSERT_TRUE(hint == hinted.lower_bound(i * 10 + 12));
+  }
+  EXPECT_TRUE(hinted == plain);
+}
+
+template <typename Set> static void random_hints(uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<uint32_t> point(0, 400);
+  std::uniform_int_distribution<uint32_t> length(0, 25);
+  Set hinted;
+  Set plain;
+  for (int i = 0; i < 5000; ++i) {
+    const uint32_t from = point(rng);
+    const uint32_t to = from + length(rng);
+    const auto hint = pick_hint(hinted, rng);
+    if (rng() % 3 == 0) {
+      const auto result = hinted.erase(hint, from, to);
+      plain.erase(from, to);
+      if (from < to) {
+        ASSERT_TRUE(result == hinted.lower_bound(to));
+      } else {
+        ASSERT_TRUE(result == hint);
+      }
+    } else {
+      const auto result = hinted.insert(hint, from, to);
+      plain.insert(from, to);
+      if (from < to) {
+        ASSERT_TRUE(result == hinted.find(from) && to <= result.to());
+      } else {
+        ASSERT_TRUE(result == hint);
+      }
+    }
+    ASSERT_TRUE(hinted == plain);
+  }
+}
+
+TEST(HintTest, RandomHintsRangeSet) {
+  random_hints<HyoutaUtilities::RangeSet<uint32_t>>(41);
+}
+
+TEST(HintTest, RandomHintsRadixRangeSet) {
+  random_hints<HyoutaUtilities::RadixRangeSet<uint32_t>>(46);
+}
+
+TEST(HintTest, RandomHintsRangeSizeSet) {
+  std::mt19937 rng(141);
+  std::uniform_int_distribution<uint32_t> point(0, 400);
+  std::uniform_int_distribution<uint32_t> length(1, 25);
+  HyoutaUtilities::RangeSizeSet<uint32_t> hinted;
+  HyoutaUtilities::RangeSizeSet<uint32_t> plain;
+  for (int i = 0; i < 5000; ++i) {
+    const uint32_t from = point(rng);
+    const uint32_t to = from + length(rng);
+    const auto hint = pick_hint(hinted, rng);
+    if (rng() % 3 == 0) {
+      auto result = hinted.erase(hint, from, to);
+      plain.erase(from, to);
+      ASSERT_TRUE(result == hinted.end() || to <= result.from());
+      if (result != hinted.begin()) {
+        ASSERT_TRUE((--result).from() < to);
+      }
+    } else {
+      const auto result = hinted.insert(hint, from, to);
+      plain.insert(from, to);
+      ASSERT_TRUE(result.from() <= from && to <= result.to());
+    }
+    ASSERT_TRUE(hinted == plain);
+
+    std::size_t by_size = 0;
+    for (auto it = hinted.by_size_begin(); it != hinted.by_size_end(); ++it)
+      ++by_size;
+    ASSERT_TRUE(by_size == hinted.size());
+  }
+}
+
+TEST(HintTest, MovedStartKeepsSizeIndex) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> rs;
+  rs.insert(10, 20);
+  rs.insert(30, 35);
+
+  // Overlapping the start of [30, 35[ moves that range's start down in place.
+  const auto result = rs.insert(--rs.end(), 25, 31);
+  EXPECT_TRUE(result.from() == 25 && result.to() == 35);
+  EXPECT_TRUE(rs.by_size_begin().from() == 10);
+  auto it = rs.by_size_find(10);
+  ++it;
+  EXPECT_TRUE(it.from() == 25 && it.to() == 35);
+  EXPECT_TRUE(it.to_range_iterator() == result);
+  EXPECT_TRUE(rs.by_size_best_fit(10).from() == 10);
+  EXPECT_TRUE(rs.by_size_best_fit(10).to_range_iterator().from() == 10);
+
+  // Erasing the start of a range moves it up in place.
+  rs.erase(result, 25, 28);
+  EXPECT_TRUE(rs.by_size_find(7).from() == 28 && rs.by_size_find(7).to() == 35);
+  rs.erase(rs.by_size_find(7));
+  EXPECT_TRUE(rs.size() == 1);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "hybridrangeset.h"
+#include "rangeset.h"
+
+using Hybrid = HyoutaUtilities::HybridRangeSet<uint32_t>;
+
+static bool same(const Hybrid& hs, const HyoutaUtilities::RangeSet<uint32_t>& rs) {
+  if (hs.size() != rs.size())
+    return false;
+  auto it = rs.begin();
+  for (auto hit = hs.begin(); hit != hs.end(); ++hit, ++it) {
+    if (it == rs.end() || hit.from() != it.from() || hit.to() != it.to())
+      return false;
+  }
+  return it == rs.end();
+}
+
+TEST(HybridTest, RangesAcrossChunks) {
+  Hybrid hs;
+  hs.insert(0xfff0, 0x30010);
+  hs.insert(0x50000, 0x50001);
+  ASSERT_TRUE(hs.size() == 2);
+  auto it = hs.begin();
+  EXPECT_TRUE(it.from() == 0xfff0);
+  EXPECT_TRUE(it.to() == 0x30010);
+  ++it;
+  EXPECT_TRUE(it.from() == 0x50000);
+  EXPECT_TRUE(it.to() == 0x50001);
+  ++it;
+  EXPECT_TRUE(it == hs.end());
+
+  hs.erase(0x20000, 0x20001);
+  ASSERT_TRUE(hs.size() == 3);
+  EXPECT_TRUE(hs.contains(0x1ffff));
+  EXPECT_FALSE(hs.contains(0x20000));
+  EXPECT_TRUE(hs.contains(0x20001));
+  EXPECT_TRUE(hs.begin().to() == 0x20000);
+
+  hs.insert(0xfffffff0, 0xffffffff);
+  EXPECT_TRUE(hs.contains(0xfffffffe));
+  EXPECT_FALSE(hs.contains(0xffffffff));
+}
+
+TEST(HybridTest, SwitchesToBitmapAndBack) {
+  Hybrid hs;
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    hs.insert(i * 4, i * 4 + 2);
+    rs.insert(i * 4, i * 4 + 2);
+  }
+  EXPECT_TRUE(hs.bitmap_chunk_count() == 1);
+  EXPECT_TRUE(same(hs, rs));
+
+  hs.erase(0, 3800);
+  rs.erase(0, 3800);
+  EXPECT_TRUE(hs.bitmap_chunk_count() == 0);
+  EXPECT_TRUE(same(hs, rs));
+}
+
+TEST(HybridTest, MatchesRangeSet) {
+  Hybrid hs;
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  std::mt19937 rng(31337);
+  std::uniform_int_distribution<uint32_t> dist(0, 0x40000);
+  bool seen_bitmap = false;
+  for (int i = 0; i < 20000; ++i) {
+    uint32_t a = dist(rng);
+    uint32_t b = a + (i % 100 == 0 ? dist(rng) / 4 : rng() % 5);
+    if (rng() % 3 != 0) {
+      hs.insert(a, b);
+      rs.insert(a, b);
+    } else {
+      hs.erase(a, b);
+      rs.erase(a, b);
+    }
+    if (i % 500 == 0) {
+      ASSERT_TRUE(same(hs, rs));
+      seen_bitmap = seen_bitmap || hs.bitmap_chunk_count() > 0;
+    }
+  }
+  ASSERT_TRUE(same(hs, rs));
+  EXPECT_TRUE(seen_bitmap);
+}
+
+TEST(HybridTest, SetAlgebra) {
+  std::mt19937 rng(99);
+  std::uniform_int_distribution<uint32_t> dist(0, 0x30000);
+  Hybrid a;
+  Hybrid b;
+  HyoutaUtilities::RangeSet<uint32_t> ra;
+  HyoutaUtilities::RangeSet<uint32_t> rb;
+  for (int i = 0; i < 3000; ++i) {
+    uint32_t x = dist(rng);
+    uint32_t y = x + 1 + rng() % (i % 2 == 0 ? 3 : 300);
+    if (i % 2 == 0) {
+      a.insert(x, y);
+      ra.insert(x, y);
+    } else {
+      b.insert(x, y);
+      rb.insert(x, y);
+    }
+  }
+
+  Hybrid u;
+  u.insert(a);
+  u.insert(b);
+  HyoutaUtilities::RangeSet<uint32_t> ru = ra;
+  for (auto it = rb.begin(); it != rb.end(); ++it)
+    ru.insert(it.from(), it.to());
+  EXPECT_TRUE(same(u, ru));
+
+  Hybrid d;
+  d.insert(a);
+  d.erase(b);
+  HyoutaUtilities::RangeSet<uint32_t> rd = ra;
+  for (auto it = rb.begin(); it != rb.end(); ++it)
+    rd.erase(it.from(), it.to());
+  EXPECT_TRUE(same(d, rd));
+
+  // a & b == a - (a - b)
+  Hybrid n;
+  n.insert(a);
+  n.intersect(b);
+  HyoutaUtilities::RangeSet<uint32_t> rn = ra;
+  for (auto it = rd.begin(); it != rd.end(); ++it)
+    rn.erase(it.from(), it.to());
+  EXPECT_TRUE(same(n, rn));
+
+  Hybrid n2;
+  n2.insert(b);
+  n2.intersect(a);
+  EXPECT_TRUE(n == n2);
+}
@@ -442,3 +442,28 @@ TEST_F(InsertTest, Tests) {
   EXPECT_TRUE(with(90, 100) == r({10, 20, 21, 30, 50, 65, 70, 71, 75, 100}));
   EXPECT_TRUE(with(95, 100) == r({10, 20, 21, 30, 50, 65, 70, 71, 75, 90, 95, 100}));
 }
+
+TEST(AppendTest, Tests) {
+  HyoutaUtilities::RangeSet<std::size_t> rs;
+  EXPECT_TRUE(rs.append(5, 5) == rs.end());
+  auto it = rs.append(10, 20);
+  EXPECT_TRUE(it.from() == 10 && it.to() == 20);
+  it = rs.append(15, 18);
+  EXPECT_TRUE(it.from() == 10 && it.to() == 20);
+  it = rs.append(20, 25);
+  EXPECT_TRUE(it.from() == 10 && it.to() == 25);
+  it = rs.append(30, 40);
+  EXPECT_TRUE(it.from() == 30 && it.to() == 40);
+  EXPECT_TRUE(rs == r({10, 25, 30, 40}));
+
+  // Not ascending, falls back to a regular insert.
+  it = rs.append(0, 12);
+  EXPECT_TRUE(it.from() == 0 && it.to() == 25);
+  EXPECT_TRUE(rs == r({0, 25, 30, 40}));
+
+  // Ascending inserts through insert() take the same path.
+  rs.insert(35, 50);
+  rs.insert(50, 60);
+  rs.insert(70, 80);
+  EXPECT_TRUE(rs == r({0, 25, 30, 60, 70, 80}));
+}
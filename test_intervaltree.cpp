@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "intervaltree.h"
+
+using Tree = HyoutaUtilities::IntervalTree<std::size_t, int>;
+using Interval = std::tuple<std::size_t, std::size_t, int>;
+
+static std::vector<Interval> containing(const Tree& t, std::size_t point) {
+  std::vector<Interval> v;
+  t.for_each_containing(point, [&](std::size_t from, std::size_t to, int value) { v.emplace_back(from, to, value); });
+  return v;
+}
+
+static std::vector<Interval> overlapping(const Tree& t, std::size_t from, std::size_t to) {
+  std::vector<Interval> v;
+  t.for_each_overlapping(from, to, [&](std::size_t f, std::size_t t, int value) { v.emplace_back(f, t, value); });
+  return v;
+}
+
+TEST(IntervalTreeTest, Stabbing) {
+  Tree t;
+  t.insert(0x1000, 0x1100, 1);
+  t.insert(0x1080, 0x1200, 2);
+  t.insert(0x1000, 0x1100, 3);
+  t.insert(0x2000, 0x2004, 4);
+  ASSERT_TRUE(t.size() == 4);
+
+  EXPECT_TRUE(containing(t, 0xfff).empty());
+  EXPECT_TRUE(containing(t, 0x1000).size() == 2);
+  EXPECT_TRUE(containing(t, 0x1090).size() == 3);
+  EXPECT_TRUE(containing(t, 0x1100) == std::vector<Interval>{Interval(0x1080, 0x1200, 2)});
+  EXPECT_TRUE(containing(t, 0x1200).empty());
+  EXPECT_TRUE(t.contains(0x2003));
+  EXPECT_FALSE(t.contains(0x2004));
+
+  EXPECT_TRUE(overlapping(t, 0x1100, 0x2001).size() == 2);
+  EXPECT_TRUE(overlapping(t, 0x1200, 0x2000).empty());
+
+  EXPECT_FALSE(t.erase(0x1000, 0x1100, 2));
+  EXPECT_TRUE(t.erase(0x1000, 0x1100, 3));
+  EXPECT_TRUE(containing(t, 0x1000) == std::vector<Interval>{Interval(0x1000, 0x1100, 1)});
+  ASSERT_TRUE(t.size() == 3);
+}
+
+TEST(IntervalTreeTest, MatchesBruteForce) {
+  Tree t;
+  std::vector<Interval> all;
+  std::mt19937 rng(2024);
+  std::uniform_int_distribution<std::size_t> dist(0, 1000);
+  for (int i = 0; i < 2000; ++i) {
+    if (all.empty() || rng() % 3 != 0) {
+      std::size_t a = dist(rng);
+      std::size_t b = a + 1 + dist(rng) / 20;
+      int v = static_cast<int>(rng() % 4);
+      t.insert(a, b, v);
+      all.emplace_back(a, b, v);
+    } else {
+      std::size_t idx = rng() % all.size();
+      auto [a, b, v] = all[idx];
+      all.erase(all.begin() + idx);
+      ASSERT_TRUE(t.erase(a, b, v));
+    }
+    ASSERT_TRUE(t.size() == all.size());
+
+    std::size_t p = dist(rng);
+    std::vector<Interval> expected;
+    for (const auto& iv : all) {
+      if (std::get<0>(iv) <= p && p < std::get<1>(iv))
+        expected.push_back(iv);
+    }
+    auto actual = containing(t, p);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    ASSERT_TRUE(actual == expected);
+    ASSERT_TRUE(t.contains(p) == !expected.empty());
+
+    std::size_t q = p + 1 + dist(rng) / 10;
+    expected.clear();
+    for (const auto& iv : all) {
+      if (std::get<0>(iv) < q && p < std::get<1>(iv))
+        expected.push_back(iv);
+    }
+    actual = overlapping(t, p, q);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    ASSERT_TRUE(actual == expected);
+  }
+
+  Tree copy = t;
+  std::size_t n = 0;
+  copy.for_each([&](std::size_t, std::size_t, int) { ++n; });
+  EXPECT_TRUE(n == all.size());
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangesizeset.h"
+
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+static Ranges by_size(const HyoutaUtilities::RangeSizeSet<uint32_t>& rs) {
+  Ranges ranges;
+  for (auto it = rs.by_size_begin(); it != rs.by_size_end(); ++it) {
+    EXPECT_TRUE(it.to_range_iterator().from() == it.from());
+    ranges.emplace_back(it.from(), it.to());
+  }
+  return ranges;
+}
+
+TEST(LazySizeTest, RebuildsOnLookup) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> rs;
+  rs.set_lazy_size_index(true);
+  EXPECT_TRUE(rs.lazy_size_index());
+  rs.insert(0, 10);
+  rs.insert(20, 25);
+  rs.insert(30, 50);
+  rs.erase(40, 45);
+  EXPECT_TRUE(rs.by_size_begin().from() == 0);
+  EXPECT_TRUE(rs.by_size_count(5) == 2);
+  EXPECT_TRUE(rs.by_size_best_fit(6).from() == 0);
+  EXPECT_TRUE(rs.begin().to_size_iterator().from() == 0);
+
+  // Erasing through a by-size iterator keeps the index up to date.
+  rs.erase(rs.by_size_find(10));
+  EXPECT_TRUE(rs.by_size_begin().from() == 30);
+  EXPECT_TRUE(rs.get_stats().first == 20);
+
+  rs.insert(100, 200);
+  rs.set_lazy_size_index(false);
+  EXPECT_FALSE(rs.lazy_size_index());
+  EXPECT_TRUE(rs.begin().to_size_iterator().from() == 20);
+  EXPECT_TRUE(rs.by_size_begin().from() == 100);
+}
+
+TEST(LazySizeTest, RandomizedMatchesEager) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> lazy;
+  HyoutaUtilities::RangeSizeSet<uint32_t> eager;
+  lazy.set_lazy_size_index(true);
+  std::mt19937 rng(50);
+  std::uniform_int_distribution<uint32_t> point(0, 1000);
+  std::uniform_int_distribution<uint32_t> length(1, 30);
+  for (int i = 0; i < 3000; ++i) {
+    const uint32_t from = point(rng);
+    const uint32_t to = from + length(rng);
+    if (rng() % 3 == 0) {
+      lazy.erase(from, to);
+      eager.erase(from, to);
+    } else {
+      lazy.insert(from, to);
+      eager.insert(from, to);
+    }
+
+    // Only look at the index now and then, like a phase of churn followed by a lookup.
+    if (i % 50 == 0) {
+      ASSERT_TRUE(by_size(lazy) == by_size(eager));
+      ASSERT_TRUE(lazy.get_stats() == eager.get_stats());
+    }
+  }
+  ASSERT_TRUE(lazy == eager);
+  ASSERT_TRUE(by_size(lazy) == by_size(eager));
+}
+
+TEST(LazySizeTest, Rollback) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> rs;
+  rs.set_lazy_size_index(true);
+  rs.insert(0, 10);
+  rs.insert(20, 30);
+  const Ranges before = by_size(rs);
+
+  rs.begin_transaction();
+  rs.insert(5, 25);
+  rs.erase(2, 3);
+  EXPECT_TRUE(rs.by_size_begin().from() == 3);
+  rs.insert(40, 41);
+  rs.rollback();
+  EXPECT_TRUE(by_size(rs) == before);
+}
+
+TEST(LazySizeTest, SwapAndClear) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> a;
+  HyoutaUtilities::RangeSizeSet<uint32_t> b;
+  a.set_lazy_size_index(true);
+  a.insert(0, 5);
+  b.insert(10, 30);
+  a.swap(b);
+  EXPECT_FALSE(a.lazy_size_index());
+  EXPECT_TRUE(b.lazy_size_index());
+  EXPECT_TRUE(a.by_size_begin().from() == 10);
+  EXPECT_TRUE(b.by_size_begin().from() == 0);
+
+  b.insert(100, 200);
+  b.clear();
+  EXPECT_TRUE(b.by_size_begin() == b.by_size_end());
+  b.insert(1, 2);
+  EXPECT_TRUE(b.by_size_begin().from() == 1);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "learnedrangeset.h"
+#include "rangeset.h"
+
+template <typename T>
+static void expect_same_lookups(const HyoutaUtilities::LearnedRangeSet<T>& ls, const HyoutaUtilities::RangeSet<T>& rs,
+                                T value) {
+  ASSERT_TRUE(ls.contains(value) == rs.contains(value));
+  const auto found = ls.find(value);
+  const auto expected = rs.find(value);
+  ASSERT_TRUE((found == ls.end()) == (expected == rs.end()));
+  if (found != ls.end()) {
+    ASSERT_TRUE(found.from() == expected.from() && found.to() == expected.to());
+  }
+}
+
+TEST(LearnedTest, Empty) {
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  auto ls = HyoutaUtilities::freeze_learned(rs);
+  EXPECT_TRUE(ls.empty());
+  EXPECT_TRUE(ls.begin() == ls.end());
+  EXPECT_TRUE(ls.segment_count() == 0);
+  EXPECT_FALSE(ls.contains(0));
+  EXPECT_TRUE(ls.find(0) == ls.end());
+  EXPECT_TRUE(ls.get_stats() == rs.get_stats());
+}
+
+TEST(LearnedTest, EvenlySpreadNeedsOneSegment) {
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  for (uint32_t i = 0; i < 10000; ++i)
+    rs.insert(i * 16, i * 16 + 5);
+  const auto ls = HyoutaUtilities::freeze_learned(rs);
+  EXPECT_TRUE(ls.segment_count() == 1);
+  for (uint32_t value = 0; value < 10000 * 16 + 32; ++value)
+    expect_same_lookups(ls, rs, value);
+}
+
+TEST(LearnedTest, Iterate) {
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  rs.insert(5, 10);
+  rs.insert(20, 30);
+  rs.insert(40, 41);
+  const auto ls = HyoutaUtilities::freeze_learned(rs);
+  auto it = rs.begin();
+  for (auto lit = ls.begin(); lit != ls.end(); ++lit, ++it)
+    EXPECT_TRUE(lit.from() == it.from() && lit.to() == it.to());
+  EXPECT_TRUE(it == rs.end());
+  EXPECT_TRUE((--ls.end()).from() == 40);
+
+  auto copy = ls;
+  EXPECT_TRUE(copy == ls);
+  HyoutaUtilities::LearnedRangeSet<uint32_t> other;
+  copy.swap(other);
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(other == ls);
+}
+
+TEST(LearnedTest, Distributions) {
+  std::mt19937_64 rng(48);
+  for (std::size_t max_error : {0, 1, 4, 32}) {
+    // Uniform, clustered, and gaps that grow exponentially so no straight line fits for long.
+    for (int kind = 0; kind < 3; ++kind) {
+      HyoutaUtilities::RangeSet<uint64_t> rs;
+      uint64_t pos = 0;
+      for (int i = 0; i < 3000; ++i) {
+        uint64_t gap;
+        if (kind == 0)
+          gap = 100 + rng() % 20;
+        else if (kind == 1)
+          gap = (i % 100 == 0) ? (uint64_t(1) << 32) + rng() % 1000 : 2 + rng() % 8;
+        else
+          gap = uint64_t(1) << (rng() % 40);
+        pos += gap;
+        rs.insert(pos, pos + 1);
+        pos += 1;
+      }
+      const auto ls = HyoutaUtilities::freeze_learned(rs, max_error);
+      ASSERT_TRUE(ls.size() == rs.size());
+      EXPECT_TRUE(ls.get_stats() == rs.get_stats());
+      for (auto it = rs.begin(); it != rs.end(); ++it) {
+        expect_same_lookups(ls, rs, it.from());
+        expect_same_lookups(ls, rs, it.from() - 1);
+        expect_same_lookups(ls, rs, it.to());
+      }
+      std::uniform_int_distribution<uint64_t> point(0, pos + 10);
+      for (int i = 0; i < 10000; ++i)
+        expect_same_lookups(ls, rs, point(rng));
+    }
+  }
+}
+
+TEST(LearnedTest, FullKeyRange) {
+  HyoutaUtilities::RangeSet<uint64_t> rs;
+  rs.insert(0, 1);
+  rs.insert(1000, 2000);
+  rs.insert(uint64_t(1) << 63, (uint64_t(1) << 63) + 10);
+  rs.insert(UINT64_MAX - 5, UINT64_MAX);
+  const auto ls = HyoutaUtilities::freeze_learned(rs, 1);
+  for (uint64_t value : {uint64_t(0), uint64_t(1), uint64_t(999), uint64_t(1500), uint64_t(1) << 63,
+                         (uint64_t(1) << 63) + 10, UINT64_MAX - 5, UINT64_MAX - 1, UINT64_MAX})
+    expect_same_lookups(ls, rs, value);
+
+  HyoutaUtilities::RangeSet<int32_t> signed_rs;
+  signed_rs.insert(INT32_MIN, INT32_MIN + 3);
+  signed_rs.insert(-5, 5);
+  signed_rs.insert(100, 200);
+  const auto signed_ls = HyoutaUtilities::freeze_learned(signed_rs, 0);
+  for (int32_t value : {INT32_MIN, INT32_MIN + 3, -6, -5, 0, 4, 5, 150, 200, INT32_MAX})
+    expect_same_lookups(signed_ls, signed_rs, value);
+}
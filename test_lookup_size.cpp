@@ -134,3 +134,46 @@ TEST(LookupSizeTest, BySizeUpperBound) {
   EXPECT_TRUE(rs.by_size_upper_bound(1) == rs.by_size_end());
   EXPECT_TRUE(rs.by_size_upper_bound(0) == rs.by_size_end());
 }
+
+TEST(LookupSizeTest, BySizeEqualSizesByAddress) {
+  HyoutaUtilities::RangeSizeSet<std::size_t> rs;
+  // Inserted out of address order.
+  rs.insert(50, 54);
+  rs.insert(10, 14);
+  rs.insert(30, 34);
+  rs.insert(70, 71);
+  rs.insert(20, 24);
+  auto it = rs.by_size_begin();
+  EXPECT_TRUE((it++).from() == 10);
+  EXPECT_TRUE((it++).from() == 20);
+  EXPECT_TRUE((it++).from() == 30);
+  EXPECT_TRUE((it++).from() == 50);
+  EXPECT_TRUE((it++).from() == 70);
+  EXPECT_TRUE(it == rs.by_size_end());
+  EXPECT_TRUE(rs.by_size_find(4).from() == 10);
+  EXPECT_TRUE(rs.by_size_lower_bound(4).from() == 10);
+  EXPECT_TRUE(rs.by_size_equal_range(4).first.from() == 10);
+
+  // Shrinking a range moves it to its new place among the equal sizes.
+  rs.erase(50, 51);
+  rs.erase(24, 25);
+  rs.erase(20, 21);
+  auto three = rs.by_size_find(3);
+  EXPECT_TRUE((three++).from() == 21);
+  EXPECT_TRUE(three.from() == 51);
+}
+
+TEST(LookupSizeTest, BySizeBestFit) {
+  HyoutaUtilities::RangeSizeSet<std::size_t> rs;
+  setup(rs);
+  rs.insert(60, 66);
+  rs.insert(2, 8);
+  EXPECT_TRUE(rs.by_size_best_fit(0).from() == 40);
+  EXPECT_TRUE(rs.by_size_best_fit(1).from() == 40);
+  EXPECT_TRUE(rs.by_size_best_fit(2).from() == 2);
+  EXPECT_TRUE(rs.by_size_best_fit(6).from() == 2);
+  EXPECT_TRUE(rs.by_size_best_fit(7).from() == 10);
+  EXPECT_TRUE(rs.by_size_best_fit(8).from() == 10);
+  EXPECT_TRUE(rs.by_size_best_fit(9).from() == 20);
+  EXPECT_TRUE(rs.by_size_best_fit(10) == rs.by_size_end());
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "rangeset.h"
+
+TEST(MergeTest, Tests) {
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  rs.insert(10, 20);
+  rs.insert(30, 40);
+
+  HyoutaUtilities::RangeSet<uint32_t> other;
+  other.insert(0, 5);
+  other.insert(15, 25);
+  other.insert(28, 30);
+  other.insert(45, 50);
+
+  rs.merge(std::move(other));
+  EXPECT_TRUE(other.empty());
+
+  HyoutaUtilities::RangeSet<uint32_t> expected;
+  expected.insert(0, 5);
+  expected.insert(10, 25);
+  expected.insert(28, 40);
+  expected.insert(45, 50);
+  EXPECT_TRUE(rs == expected);
+
+  HyoutaUtilities::RangeSet<uint32_t> empty;
+  rs.merge(std::move(empty));
+  EXPECT_TRUE(rs == expected);
+  empty.merge(std::move(rs));
+  EXPECT_TRUE(empty == expected);
+}
+
+TEST(MergeTest, RandomizedAgainstInsert) {
+  std::mt19937 rng(44);
+  std::uniform_int_distribution<uint32_t> point(0, 2000);
+  std::uniform_int_distribution<uint32_t> length(1, 40);
+  for (int round = 0; round < 300; ++round) {
+    HyoutaUtilities::RangeSet<uint32_t> a;
+    HyoutaUtilities::RangeSet<uint32_t> b;
+    for (int i = 0; i < 30; ++i) {
+      const uint32_t from = point(rng);
+      a.insert(from, from + length(rng));
+    }
+    for (int i = 0; i < 30; ++i) {
+      const uint32_t from = point(rng);
+      b.insert(from, from + length(rng));
+    }
+
+    HyoutaUtilities::RangeSet<uint32_t> expected = a;
+    for (auto it = b.begin(); it != b.end(); ++it)
+      expected.insert(it.from(), it.to());
+
+    a.merge(std::move(b));
+    ASSERT_TRUE(b.empty());
+    ASSERT_TRUE(a == expected);
+  }
+}
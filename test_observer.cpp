@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+
+#include "rangeset.h"
+
+namespace {
+// Replays all reported changes on a plain map, which should then always match the observed set.
+struct Mirror {
+  std::map<uint32_t, uint32_t> Ranges;
+  int Added = 0;
+  int Removed = 0;
+  int Expanded = 0;
+  int Shrunk = 0;
+  int Split = 0;
+  int Merged = 0;
+};
+
+struct MirrorObserver {
+  Mirror* Target = nullptr;
+
+  void range_added(uint32_t from, uint32_t to) {
+    ASSERT_TRUE(Target->Ranges.emplace(from, to).second);
+    ++Target->Added;
+  }
+
+  void range_removed(uint32_t from, uint32_t to) {
+    ASSERT_TRUE(Target->Ranges.count(from) == 1 && Target->Ranges[from] == to);
+    Target->Ranges.erase(from);
+    ++Target->Removed;
+  }
+
+  void range_expanded(uint32_t from, uint32_t old_to, uint32_t new_to) {
+    ASSERT_TRUE(Target->Ranges.count(from) == 1 && Target->Ranges[from] == old_to && old_to < new_to);
+    Target->Ranges[from] = new_to;
+    ++Target->Expanded;
+  }
+
+  void range_shrunk(uint32_t old_from, uint32_t old_to, uint32_t new_from, uint32_t new_to) {
+    ASSERT_TRUE(Target->Ranges.count(old_from) == 1 && Target->Ranges[old_from] == old_to);
+    ASSERT_TRUE(old_from <= new_from && new_to <= old_to);
+    Target->Ranges.erase(old_from);
+    Target->Ranges.emplace(new_from, new_to);
+    ++Target->Shrunk;
+  }
+
+  void range_split(uint32_t from, uint32_t to, uint32_t hole_from, uint32_t hole_to) {
+    ASSERT_TRUE(Target->Ranges.count(from) == 1 && Target->Ranges[from] == to);
+    Target->Ranges[from] = hole_from;
+    Target->Ranges.emplace(hole_to, to);
+    ++Target->Split;
+  }
+
+  void range_merged(uint32_t from, uint32_t to, uint32_t absorbed_from, uint32_t absorbed_to) {
+    ASSERT_TRUE(Target->Ranges.count(absorbed_from) == 1 && Target->Ranges[absorbed_from] == absorbed_to);
+    ASSERT_TRUE(Target->Ranges.count(from) == 1);
+    Target->Ranges.erase(absorbed_from);
+    Target->Ranges[from] = to;
+    ++Target->Merged;
+  }
+};
+
+using ObservedSet = HyoutaUtilities::RangeSet<uint32_t, MirrorObserver>;
+
+bool matches(const ObservedSet& rs, const Mirror& mirror) {
+  if (rs.size() != mirror.Ranges.size())
+    return false;
+  auto m = mirror.Ranges.begin();
+  for (auto it = rs.begin(); it != rs.end(); ++it, ++m) {
+    if (it.from() != m->first || it.to() != m->second)
+      return false;
+  }
+  return true;
+}
+} // namespace
+
+TEST(ObserverTest, ReportsEachKindOfChange) {
+  Mirror mirror;
+  ObservedSet rs(MirrorObserver{&mirror});
+
+  rs.insert(10, 20);
+  EXPECT_TRUE(mirror.Added == 1);
+  rs.insert(30, 40);
+  rs.insert(15, 25);
+  EXPECT_TRUE(mirror.Expanded == 1);
+  rs.insert(5, 35);
+  EXPECT_TRUE(mirror.Added == 3);
+  EXPECT_TRUE(mirror.Merged == 2);
+  rs.erase(12, 14);
+  EXPECT_TRUE(mirror.Split == 1);
+  rs.erase(38, 50);
+  rs.erase(0, 7);
+  EXPECT_TRUE(mirror.Shrunk == 2);
+  rs.erase(rs.begin());
+  EXPECT_TRUE(mirror.Removed == 1);
+  EXPECT_TRUE(matches(rs, mirror));
+
+  rs.clear();
+  EXPECT_TRUE(mirror.Ranges.empty());
+}
+
+TEST(ObserverTest, SplitReportsToBothSets) {
+  Mirror lower_mirror;
+  Mirror upper_mirror;
+  ObservedSet rs(MirrorObserver{&lower_mirror});
+  rs.insert(0, 10);
+  rs.insert(20, 30);
+  rs.insert(40, 50);
+  ObservedSet upper = rs.split_at(25, MirrorObserver{&upper_mirror});
+  EXPECT_TRUE(matches(rs, lower_mirror));
+  EXPECT_TRUE(matches(upper, upper_mirror));
+  EXPECT_TRUE(upper_mirror.Added == 2);
+}
+
+TEST(ObserverTest, RandomizedMirrorStaysInSync) {
+  Mirror mirror;
+  ObservedSet rs(MirrorObserver{&mirror});
+  std::mt19937 rng(38);
+  std::uniform_int_distribution<uint32_t> point(0, 500);
+  std::uniform_int_distribution<uint32_t> length(1, 30);
+  for (int i = 0; i < 5000; ++i) {
+    const uint32_t from = point(rng);
+    const uint32_t to = from + length(rng);
+    if (rng() % 3 == 0)
+      rs.erase(from, to);
+    else
+      rs.insert(from, to);
+    ASSERT_TRUE(matches(rs, mirror));
+  }
+}
+
+TEST(ObserverTest, DefaultObserverTakesNoSpace) {
+  EXPECT_TRUE(sizeof(HyoutaUtilities::RangeSet<uint32_t>) == sizeof(std::map<uint32_t, uint32_t>));
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "pagelookuptable.h"
+#include "rangeset.h"
+
+using PageTable = HyoutaUtilities::PageLookupTable<uint32_t>;
+using PagedSet = HyoutaUtilities::RangeSet<uint32_t, PageTable>;
+
+// Every page the table claims to know about must agree with the set.
+static bool table_is_consistent(const PagedSet& rs) {
+  const PageTable& table = rs.observer();
+  for (std::size_t page = 0; page < table.page_count(); ++page) {
+    const uint32_t from = table.base() + static_cast<uint32_t>(page * table.page_size());
+    const uint32_t last = from + static_cast<uint32_t>(table.page_size() - 1);
+    const PageTable::PageState state = table.classify(from);
+    if (state == PageTable::PageState::Inside) {
+      auto it = rs.find(from);
+      if (it == rs.end() || it.to() <= last)
+        return false;
+    } else if (state == PageTable::PageState::Outside) {
+      if (rs.find(from) != rs.end())
+        return false;
+      auto it = rs.upper_bound(from);
+      if (it != rs.end() && it.from() <= last)
+        return false;
+    }
+  }
+  return true;
+}
+
+TEST(PageTableTest, Classify) {
+  PagedSet rs(PageTable(0x1000, 4, 8));
+  EXPECT_TRUE(rs.observer().memory_usage() == 4);
+  rs.insert(0x1000, 0x1280);
+  EXPECT_TRUE(rs.observer().classify(0x1000) == PageTable::PageState::Inside);
+  EXPECT_TRUE(rs.observer().classify(0x11FF) == PageTable::PageState::Inside);
+  EXPECT_TRUE(rs.observer().classify(0x1200) == PageTable::PageState::Mixed);
+  EXPECT_TRUE(rs.observer().classify(0x1300) == PageTable::PageState::Outside);
+  EXPECT_TRUE(rs.observer().classify(0xFFF) == PageTable::PageState::Mixed);
+  EXPECT_TRUE(rs.observer().classify(0x1400) == PageTable::PageState::Mixed);
+
+  rs.erase(0x1080, 0x1100);
+  EXPECT_TRUE(rs.observer().classify(0x1000) == PageTable::PageState::Mixed);
+  EXPECT_TRUE(rs.observer().classify(0x1100) == PageTable::PageState::Inside);
+  EXPECT_TRUE(fast_contains(rs, 0x1000u));
+  EXPECT_FALSE(fast_contains(rs, 0x1080u));
+  EXPECT_TRUE(fast_contains(rs, 0x1100u));
+  EXPECT_FALSE(fast_contains(rs, 0x1300u));
+  EXPECT_TRUE(table_is_consistent(rs));
+
+  rs.clear();
+  EXPECT_TRUE(rs.observer().classify(0x1100) == PageTable::PageState::Outside);
+}
+
+TEST(PageTableTest, RebuildIsExact) {
+  PagedSet rs(PageTable(0, 16, 4));
+  rs.insert(0, 8);
+  rs.insert(8, 16);
+  // Neither change covered page 0 on its own, but the merge reports the whole range.
+  EXPECT_TRUE(rs.observer().classify(0) == PageTable::PageState::Inside);
+
+  rs.insert(16, 20);
+  rs.insert(28, 32);
+  rs.erase(16, 20);
+  rs.erase(28, 32);
+  // Page 1 is empty now, but each erase only saw part of it.
+  EXPECT_TRUE(rs.observer().classify(16) == PageTable::PageState::Mixed);
+  EXPECT_TRUE(rs.observer().count_mixed() == 1);
+  rs.observer().rebuild(rs);
+  EXPECT_TRUE(rs.observer().classify(16) == PageTable::PageState::Outside);
+  EXPECT_TRUE(rs.observer().count_mixed() == 0);
+}
+
+TEST(PageTableTest, RandomizedMatchesTree) {
+  // A window that doesn't cover everything, so clipping at both ends gets exercised.
+  PagedSet rs(PageTable(100, 64, 4));
+  std::mt19937 rng(47);
+  std::uniform_int_distribution<uint32_t> point(0, 1300);
+  std::uniform_int_distribution<uint32_t> length(1, 60);
+  for (int i = 0; i < 5000; ++i) {
+    const uint32_t from = point(rng);
+    const uint32_t to = from + length(rng);
+    if (rng() % 3 == 0)
+      rs.erase(from, to);
+    else
+      rs.insert(from, to);
+    ASSERT_TRUE(table_is_consistent(rs));
+    for (int j = 0; j < 16; ++j) {
+      const uint32_t value = point(rng);
+      ASSERT_TRUE(fast_contains(rs, value) == rs.contains(value));
+    }
+  }
+
+  rs.observer().rebuild(rs);
+  ASSERT_TRUE(table_is_consistent(rs));
+  for (uint32_t value = 0; value < 1400; ++value)
+    ASSERT_TRUE(fast_contains(rs, value) == rs.contains(value));
+}
+
+TEST(PageTableTest, SplitFillsTableOfResult) {
+  PagedSet rs(PageTable(0, 8, 4));
+  rs.insert(0, 128);
+  PagedSet upper = rs.split_at(64, PageTable(0, 8, 4));
+  EXPECT_TRUE(table_is_consistent(rs));
+  EXPECT_TRUE(table_is_consistent(upper));
+  EXPECT_FALSE(fast_contains(rs, 64u));
+  EXPECT_TRUE(fast_contains(rs, 63u));
+  EXPECT_FALSE(fast_contains(upper, 0u));
+  EXPECT_FALSE(fast_contains(upper, 63u));
+  EXPECT_TRUE(fast_contains(upper, 64u));
+
+  // A range reaching across the split point is cut in two.
+  PagedSet middle = upper.split_at(100, PageTable(0, 8, 4));
+  EXPECT_TRUE(table_is_consistent(upper));
+  EXPECT_TRUE(table_is_consistent(middle));
+  EXPECT_TRUE(fast_contains(upper, 99u));
+  EXPECT_FALSE(fast_contains(upper, 100u));
+  EXPECT_FALSE(fast_contains(middle, 99u));
+  EXPECT_TRUE(fast_contains(middle, 100u));
+}
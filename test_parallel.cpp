@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangeset.h"
+#include "rangesetparallel.h"
+
+using Ranges = std::vector<std::pair<uint64_t, uint64_t>>;
+
+static Ranges random_ranges(std::mt19937& rng, std::size_t count, uint64_t space, uint64_t max_length) {
+  std::uniform_int_distribution<uint64_t> start(0, space);
+  std::uniform_int_distribution<uint64_t> length(0, max_length);
+  Ranges ranges;
+  ranges.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const uint64_t from = start(rng);
+    ranges.emplace_back(from, from + length(rng));
+  }
+  return ranges;
+}
+
+static HyoutaUtilities::RangeSet<uint64_t> build_serial(const Ranges& ranges) {
+  HyoutaUtilities::RangeSet<uint64_t> rs;
+  for (const auto& range : ranges)
+    rs.insert(range.first, range.second);
+  return rs;
+}
+
+TEST(ParallelTest, BuildMatchesInsert) {
+  std::mt19937 rng(35);
+  for (uint64_t max_length : {1, 20, 5000}) {
+    const Ranges ranges = random_ranges(rng, 60000, 1000000, max_length);
+    const auto expected = build_serial(ranges);
+    for (unsigned threads : {1, 2, 3, 8}) {
+      EXPECT_TRUE(HyoutaUtilities::build_range_set_parallel(ranges, threads) == expected);
+    }
+  }
+}
+
+TEST(ParallelTest, BuildSmallInputs) {
+  EXPECT_TRUE(HyoutaUtilities::build_range_set_parallel(Ranges(), 4).empty());
+
+  const Ranges ranges = {{10, 20}, {5, 5}, {20, 30}, {1, 3}};
+  auto rs = HyoutaUtilities::build_range_set_parallel(ranges, 4);
+  ASSERT_TRUE(rs.size() == 2);
+  EXPECT_TRUE(rs.begin().from() == 1);
+  EXPECT_TRUE(rs.begin().to() == 3);
+  EXPECT_TRUE((++rs.begin()).from() == 10);
+  EXPECT_TRUE((++rs.begin()).to() == 30);
+}
+
+TEST(ParallelTest, UnionAndIntersectionMatchSerial) {
+  std::mt19937 rng(135);
+  for (uint64_t max_length : {3, 50, 2000}) {
+    const auto a = build_serial(random_ranges(rng, 40000, 2000000, max_length));
+    const auto b = build_serial(random_ranges(rng, 25000, 2000000, max_length));
+
+    auto expected_union = a;
+    for (auto it = b.begin(); it != b.end(); ++it)
+      expected_union.insert(it.from(), it.to());
+
+    // a - (a - b)
+    auto a_minus_b = a;
+    for (auto it = b.begin(); it != b.end(); ++it)
+      a_minus_b.erase(it.from(), it.to());
+    auto expected_intersection = a;
+    for (auto it = a_minus_b.begin(); it != a_minus_b.end(); ++it)
+      expected_intersection.erase(it.from(), it.to());
+
+    for (unsigned threads : {1, 2, 5, 8}) {
+      EXPECT_TRUE(HyoutaUtilities::union_parallel(a, b, threads) == expected_union);
+      EXPECT_TRUE(HyoutaUtilities::union_parallel(b, a, threads) == expected_union);
+      EXPECT_TRUE(HyoutaUtilities::intersection_parallel(a, b, threads) == expected_intersection);
+      EXPECT_TRUE(HyoutaUtilities::intersection_parallel(b, a, threads) == expected_intersection);
+    }
+  }
+}
+
+TEST(ParallelTest, SetAlgebraWithEmptySide) {
+  std::mt19937 rng(235);
+  const auto a = build_serial(random_ranges(rng, 20000, 1000000, 10));
+  const HyoutaUtilities::RangeSet<uint64_t> empty;
+  EXPECT_TRUE(HyoutaUtilities::union_parallel(a, empty, 4) == a);
+  EXPECT_TRUE(HyoutaUtilities::union_parallel(empty, a, 4) == a);
+  EXPECT_TRUE(HyoutaUtilities::intersection_parallel(a, empty, 4).empty());
+  EXPECT_TRUE(HyoutaUtilities::intersection_parallel(empty, empty, 4).empty());
+}
+
+TEST(ParallelTest, ReduceWindowMatchesSerial) {
+  std::mt19937 rng(36);
+  const auto rs = build_serial(random_ranges(rng, 50000, 1000000, 40));
+  std::uniform_int_distribution<uint64_t> point(0, 1000100);
+  for (int round = 0; round < 20; ++round) {
+    uint64_t lo = point(rng);
+    uint64_t hi = point(rng);
+    if (lo > hi)
+      std::swap(lo, hi);
+
+    uint64_t expected_covered = 0;
+    std::size_t expected_count = 0;
+    for (auto it = rs.begin(); it != rs.end(); ++it) {
+      const uint64_t from = std::max(it.from(), lo);
+      const uint64_t to = std::min(it.to(), hi);
+      if (from < to) {
+        expected_covered += to - from;
+        ++expected_count;
+      }
+    }
+
+    for (unsigned threads : {1, 3, 8}) {
+      using Acc = std::pair<uint64_t, std::size_t>;
+      const Acc result = HyoutaUtilities::reduce_parallel(
+          rs, lo, hi, Acc(0, 0),
+          [](Acc& acc, uint64_t from, uint64_t to) {
+            acc.first += to - from;
+            ++acc.second;
+          },
+          [](Acc& acc, const Acc& other) {
+            acc.first += other.first;
+            acc.second += other.second;
+          },
+          threads);
+      EXPECT_TRUE(result.first == expected_covered);
+      EXPECT_TRUE(result.second == expected_count);
+    }
+  }
+}
+
+TEST(ParallelTest, ReduceSignedWindowWiderThanHalfTheType) {
+  // Ranges spread over all of int32_t, so the window is wider than INT32_MAX.
+  HyoutaUtilities::RangeSet<int32_t> rs;
+  std::size_t expected_count = 0;
+  for (int64_t from = INT32_MIN; from + 100 < INT32_MAX; from += 200000) {
+    rs.insert(static_cast<int32_t>(from), static_cast<int32_t>(from + 100));
+    ++expected_count;
+  }
+  for (unsigned threads : {1, 2, 3}) {
+    const std::size_t count = HyoutaUtilities::reduce_parallel(
+        rs, INT32_MIN, INT32_MAX, std::size_t(0), [](std::size_t& acc, int32_t, int32_t) { ++acc; },
+        [](std::size_t& acc, const std::size_t& other) { acc += other; }, threads);
+    EXPECT_TRUE(count == expected_count);
+  }
+}
+
+TEST(ParallelTest, HistogramAndStats) {
+  std::mt19937 rng(136);
+  const auto rs = build_serial(random_ranges(rng, 50000, 4000000, 300));
+
+  std::vector<std::size_t> expected(6, 0);
+  for (auto it = rs.begin(); it != rs.end(); ++it) {
+    std::size_t bucket = 0;
+    while (bucket + 1 < expected.size() && (uint64_t(2) << bucket) <= it.to() - it.from())
+      ++bucket;
+    ++expected[bucket];
+  }
+
+  for (unsigned threads : {1, 2, 7}) {
+    EXPECT_TRUE(HyoutaUtilities::size_histogram_parallel(rs, 6, threads) == expected);
+    EXPECT_TRUE(HyoutaUtilities::get_stats_parallel(rs, threads) == rs.get_stats());
+  }
+
+  const HyoutaUtilities::RangeSet<uint64_t> empty;
+  EXPECT_TRUE(HyoutaUtilities::size_histogram_parallel(empty, 4, 4) == std::vector<std::size_t>(4, 0));
+  EXPECT_TRUE(HyoutaUtilities::get_stats_parallel(empty, 4) == empty.get_stats());
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "radixrangeset.h"
+#include "rangeset.h"
+
+template <typename T>
+static bool same(const HyoutaUtilities::RadixRangeSet<T>& xs, const HyoutaUtilities::RangeSet<T>& rs) {
+  if (xs.size() != rs.size())
+    return false;
+  auto it = rs.begin();
+  for (auto xit = xs.begin(); xit != xs.end(); ++xit, ++it) {
+    if (it == rs.end() || xit.from() != it.from() || xit.to() != it.to())
+      return false;
+  }
+  if (it != rs.end())
+    return false;
+
+  // And the same backwards.
+  auto xit = xs.end();
+  for (auto rit = rs.end(); rit != rs.begin();) {
+    --rit;
+    --xit;
+    if (xit.from() != rit.from() || xit.to() != rit.to())
+      return false;
+  }
+  return xit == xs.begin();
+}
+
+TEST(RadixTest, Basic) {
+  HyoutaUtilities::RadixRangeSet<uint32_t> xs;
+  EXPECT_TRUE(xs.empty());
+  EXPECT_TRUE(xs.begin() == xs.end());
+  EXPECT_FALSE(xs.contains(0));
+
+  xs.insert(10, 20);
+  xs.insert(30, 40);
+  xs.insert(20, 30);
+  EXPECT_TRUE(xs.size() == 1);
+  EXPECT_TRUE(xs.begin().from() == 10 && xs.begin().to() == 40);
+
+  xs.erase(15, 35);
+  EXPECT_TRUE(xs.size() == 2);
+  EXPECT_TRUE(xs.contains(14));
+  EXPECT_FALSE(xs.contains(15));
+  EXPECT_FALSE(xs.contains(34));
+  EXPECT_TRUE(xs.contains(35));
+  EXPECT_TRUE(xs.find(37).from() == 35);
+  EXPECT_TRUE(xs.lower_bound(11).from() == 35);
+  EXPECT_TRUE(xs.upper_bound(35) == xs.end());
+
+  auto it = xs.erase(xs.begin());
+  EXPECT_TRUE(it == xs.begin());
+  EXPECT_TRUE(it.from() == 35 && it.to() == 40);
+  xs.clear();
+  EXPECT_TRUE(xs.empty());
+}
+
+TEST(RadixTest, Append) {
+  HyoutaUtilities::RadixRangeSet<uint32_t> xs;
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    const uint32_t from = i * 10;
+    const uint32_t to = from + 5 + (i % 3) * 3;
+    const auto it = xs.append(from, to);
+    rs.append(from, to);
+    ASSERT_TRUE(it.from() <= from && to <= it.to());
+  }
+  EXPECT_TRUE(same(xs, rs));
+  EXPECT_TRUE(xs.append(5, 5) == xs.end());
+
+  // Out of order ranges are inserted like with insert().
+  xs.append(3, 12);
+  rs.append(3, 12);
+  EXPECT_TRUE(same(xs, rs));
+}
+
+TEST(RadixTest, ExtremeKeys) {
+  HyoutaUtilities::RadixRangeSet<uint64_t> xs;
+  xs.insert(0, 1);
+  xs.insert(UINT64_MAX - 1, UINT64_MAX);
+  xs.insert(uint64_t(1) << 47, (uint64_t(1) << 47) + 4096);
+  EXPECT_TRUE(xs.size() == 3);
+  EXPECT_TRUE(xs.contains(0));
+  EXPECT_TRUE(xs.contains(UINT64_MAX - 1));
+  EXPECT_FALSE(xs.contains(UINT64_MAX));
+  EXPECT_TRUE((--xs.end()).from() == UINT64_MAX - 1);
+  EXPECT_TRUE(xs.upper_bound(UINT64_MAX - 1) == xs.end());
+
+  HyoutaUtilities::RadixRangeSet<int32_t> signed_xs;
+  signed_xs.insert(-10, 10);
+  signed_xs.insert(INT32_MIN, INT32_MIN + 5);
+  EXPECT_TRUE(signed_xs.begin().from() == INT32_MIN);
+  EXPECT_TRUE(signed_xs.contains(-1));
+  EXPECT_FALSE(signed_xs.contains(10));
+}
+
+TEST(RadixTest, Pointers) {
+  static char buffer[256];
+  HyoutaUtilities::RadixRangeSet<char*> xs;
+  HyoutaUtilities::RangeSet<char*> rs;
+  xs.insert(buffer + 16, buffer + 64);
+  rs.insert(buffer + 16, buffer + 64);
+  xs.erase(buffer + 32, buffer + 40);
+  rs.erase(buffer + 32, buffer + 40);
+  EXPECT_TRUE(same(xs, rs));
+  EXPECT_TRUE(xs.contains(buffer + 16));
+  EXPECT_FALSE(xs.contains(buffer + 32));
+  EXPECT_TRUE(xs.get_stats() == rs.get_stats());
+}
+
+template <typename T> static void random_against_rangeset(uint32_t seed, T lo, T hi, T maxlength) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<T> point(lo, hi);
+  std::uniform_int_distribution<T> length(1, maxlength);
+  HyoutaUtilities::RadixRangeSet<T> xs;
+  HyoutaUtilities::RangeSet<T> rs;
+  for (int i = 0; i < 3000; ++i) {
+    const T from = point(rng);
+    const T to = from + length(rng);
+    if (rng() % 3 == 0) {
+      xs.erase(from, to);
+      rs.erase(from, to);
+    } else {
+      xs.insert(from, to);
+      rs.insert(from, to);
+    }
+    ASSERT_TRUE(same(xs, rs));
+    for (int j = 0; j < 8; ++j) {
+      const T value = point(rng);
+      ASSERT_TRUE(xs.contains(value) == rs.contains(value));
+      const auto found = xs.find(value);
+      const auto expected = rs.find(value);
+      ASSERT_TRUE((found == xs.end()) == (expected == rs.end()));
+      if (found != xs.end()) {
+        ASSERT_TRUE(found.from() == expected.from() && found.to() == expected.to());
+      }
+    }
+  }
+  EXPECT_TRUE(xs.get_stats() == rs.get_stats());
+
+  // Copies are independent, and equal until one of them changes.
+  HyoutaUtilities::RadixRangeSet<T> copy = xs;
+  EXPECT_TRUE(copy == xs);
+  copy.insert(lo, hi);
+  EXPECT_TRUE(copy != xs);
+  EXPECT_TRUE(same(xs, rs));
+
+  // Erasing everything from the front leaves an empty tree behind.
+  for (auto it = xs.begin(); it != xs.end();)
+    it = xs.erase(it);
+  EXPECT_TRUE(xs.empty());
+  EXPECT_TRUE(xs.begin() == xs.end());
+}
+
+TEST(RadixTest, RandomDense) {
+  random_against_rangeset<uint32_t>(46, 0, 2000, 40);
+}
+
+TEST(RadixTest, RandomSparse) {
+  random_against_rangeset<uint64_t>(47, 0, (uint64_t(1) << 48) - 1, uint64_t(1) << 30);
+}
+
+TEST(RadixTest, RandomSigned) {
+  random_against_rangeset<int32_t>(48, -1000, 1000, 30);
+}
+
+TEST(RadixTest, Swap) {
+  HyoutaUtilities::RadixRangeSet<uint32_t> a;
+  HyoutaUtilities::RadixRangeSet<uint32_t> b;
+  a.insert(1, 2);
+  b.insert(5, 8);
+  b.insert(10, 12);
+  a.swap(b);
+  EXPECT_TRUE(a.size() == 2 && b.size() == 1);
+  EXPECT_TRUE(b.begin().from() == 1);
+  EXPECT_TRUE(a.contains(11));
+
+  HyoutaUtilities::RadixRangeSet<uint32_t> moved = std::move(a);
+  EXPECT_TRUE(a.empty());
+  EXPECT_TRUE(moved.size() == 2);
+}
+
+TEST(RadixTest, SharedPrefixes) {
+  // Keys that only differ in their lowest digit need a chain of nodes down to the last level.
+  HyoutaUtilities::RadixRangeSet<uint64_t> xs;
+  HyoutaUtilities::RangeSet<uint64_t> rs;
+  for (uint64_t from : {uint64_t(0), uint64_t(2), uint64_t(1) << 40, (uint64_t(1) << 40) + 2}) {
+    xs.insert(from, from + 1);
+    rs.insert(from, from + 1);
+  }
+  EXPECT_TRUE(same(xs, rs));
+  HyoutaUtilities::RadixRangeSet<uint64_t> copy = xs;
+
+  // Merging the ranges around 1 removes the range at 2 and with it the chain that held the range at 0.
+  xs.insert(1, 2);
+  rs.insert(1, 2);
+  EXPECT_TRUE(same(xs, rs));
+  EXPECT_TRUE(xs.find(2).from() == 0 && xs.find(2).to() == 3);
+
+  xs.erase(1, (uint64_t(1) << 40) + 1);
+  rs.erase(1, (uint64_t(1) << 40) + 1);
+  EXPECT_TRUE(same(xs, rs));
+  EXPECT_TRUE(copy.size() == 4);
+  EXPECT_TRUE(copy.contains(uint64_t(1) << 40));
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangecountset.h"
+
+using CountSet = HyoutaUtilities::RangeCountSet<std::size_t>;
+
+TEST(RangeCountTest, AddRemove) {
+  CountSet cs;
+  cs.add(10, 30);
+  cs.add(20, 40);
+  ASSERT_TRUE(cs.size() == 3);
+  EXPECT_TRUE(cs.count_at(9) == 0);
+  EXPECT_TRUE(cs.count_at(10) == 1);
+  EXPECT_TRUE(cs.count_at(20) == 2);
+  EXPECT_TRUE(cs.count_at(29) == 2);
+  EXPECT_TRUE(cs.count_at(30) == 1);
+  EXPECT_TRUE(cs.count_at(40) == 0);
+
+  // Filling the gap on both sides coalesces everything with count 2 into one segment.
+  cs.add(10, 20);
+  cs.add(30, 40);
+  ASSERT_TRUE(cs.size() == 1);
+  EXPECT_TRUE(cs.begin().from() == 10);
+  EXPECT_TRUE(cs.begin().to() == 40);
+  EXPECT_TRUE(cs.begin().count() == 2);
+
+  std::vector<std::pair<std::size_t, std::size_t>> zeroed;
+  auto on_zero = [&](std::size_t from, std::size_t to) { zeroed.emplace_back(from, to); };
+  cs.remove(15, 25, on_zero);
+  EXPECT_TRUE(zeroed.empty());
+  cs.remove(10, 20, on_zero);
+  ASSERT_TRUE(zeroed.size() == 1);
+  EXPECT_TRUE(zeroed[0] == std::make_pair(std::size_t(15), std::size_t(20)));
+  EXPECT_TRUE(cs.count_at(12) == 1);
+  EXPECT_TRUE(cs.count_at(17) == 0);
+  EXPECT_TRUE(cs.count_at(22) == 1);
+  EXPECT_TRUE(cs.count_at(27) == 2);
+}
+
+TEST(RangeCountTest, RangesAtLeast) {
+  CountSet cs;
+  cs.add(0, 10);
+  cs.add(5, 15);
+  cs.add(8, 20);
+  cs.add(30, 40);
+
+  auto one = cs.ranges_at_least(1);
+  ASSERT_TRUE(one.size() == 2);
+  EXPECT_TRUE(one.begin().from() == 0);
+  EXPECT_TRUE(one.begin().to() == 20);
+
+  auto two = cs.ranges_at_least(2);
+  ASSERT_TRUE(two.size() == 1);
+  EXPECT_TRUE(two.begin().from() == 5);
+  EXPECT_TRUE(two.begin().to() == 15);
+
+  auto three = cs.ranges_at_least(3);
+  ASSERT_TRUE(three.size() == 1);
+  EXPECT_TRUE(three.begin().from() == 8);
+  EXPECT_TRUE(three.begin().to() == 10);
+
+  EXPECT_TRUE(cs.ranges_at_least(4).empty());
+}
+
+TEST(RangeCountTest, MatchesArray) {
+  constexpr std::size_t Size = 150;
+  CountSet cs;
+  std::vector<std::size_t> model(Size, 0);
+  std::vector<std::pair<std::size_t, std::size_t>> added;
+  std::mt19937 rng(4242);
+  std::uniform_int_distribution<std::size_t> dist(0, Size);
+  for (int i = 0; i < 3000; ++i) {
+    if (added.empty() || rng() % 5 < 3) {
+      std::size_t a = dist(rng);
+      std::size_t b = dist(rng);
+      if (a > b)
+        std::swap(a, b);
+      cs.add(a, b);
+      added.emplace_back(a, b);
+      for (std::size_t j = a; j < b; ++j)
+        ++model[j];
+    } else {
+      // Only remove what was added before, so counts never go below zero.
+      std::size_t idx = rng() % added.size();
+      auto r = added[idx];
+      added.erase(added.begin() + idx);
+      std::vector<std::size_t> before = model;
+      for (std::size_t j = r.first; j < r.second; ++j)
+        --model[j];
+      cs.remove(r.first, r.second, [&](std::size_t from, std::size_t to) {
+        for (std::size_t j = from; j < to; ++j) {
+          ASSERT_TRUE(before[j] == 1);
+          ASSERT_TRUE(model[j] == 0);
+        }
+      });
+    }
+
+    // Compare against the maximal runs of the model.
+    auto it = cs.begin();
+    for (std::size_t j = 0; j < Size;) {
+      std::size_t k = j;
+      while (k < Size && model[k] == model[j])
+        ++k;
+      if (model[j] != 0) {
+        ASSERT_TRUE(it != cs.end());
+        ASSERT_TRUE(it.from() == j);
+        ASSERT_TRUE(it.to() == k);
+        ASSERT_TRUE(it.count() == model[j]);
+        ++it;
+      }
+      j = k;
+    }
+    ASSERT_TRUE(it == cs.end());
+  }
+}
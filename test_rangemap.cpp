@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rangemap.h"
+
+using Map = HyoutaUtilities::RangeMap<std::size_t, int>;
+
+struct Entry {
+  std::size_t from;
+  std::size_t to;
+  int value;
+};
+
+static std::vector<Entry> entries(const Map& m) {
+  std::vector<Entry> v;
+  for (auto it = m.begin(); it != m.end(); ++it)
+    v.push_back({it.from(), it.to(), it.value()});
+  return v;
+}
+
+static bool is(const Map& m, std::vector<Entry> expected) {
+  auto v = entries(m);
+  if (v.size() != expected.size())
+    return false;
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    if (v[i].from != expected[i].from || v[i].to != expected[i].to || v[i].value != expected[i].value)
+      return false;
+  }
+  return true;
+}
+
+TEST(RangeMapTest, AssignSplitsAndCoalesces) {
+  Map m;
+  m.assign(10, 20, 1);
+  m.assign(30, 40, 2);
+  EXPECT_TRUE(is(m, {{10, 20, 1}, {30, 40, 2}}));
+
+  // Overwrite the middle of a range.
+  m.assign(12, 15, 3);
+  EXPECT_TRUE(is(m, {{10, 12, 1}, {12, 15, 3}, {15, 20, 1}, {30, 40, 2}}));
+
+  // Overwrite it back, which must coalesce into a single range again.
+  m.assign(12, 15, 1);
+  EXPECT_TRUE(is(m, {{10, 20, 1}, {30, 40, 2}}));
+
+  // Touching ranges with different values stay separate.
+  m.assign(20, 30, 4);
+  EXPECT_TRUE(is(m, {{10, 20, 1}, {20, 30, 4}, {30, 40, 2}}));
+
+  // Touching ranges with equal values are merged on both sides.
+  m.assign(20, 30, 2);
+  EXPECT_TRUE(is(m, {{10, 20, 1}, {20, 40, 2}}));
+  m.assign(5, 35, 2);
+  EXPECT_TRUE(is(m, {{5, 40, 2}}));
+}
+
+TEST(RangeMapTest, AssignValueFromItself) {
+  // The value refers to a range that assign() overwrites.
+  HyoutaUtilities::RangeMap<std::size_t, std::string> m;
+  m.assign(10, 20, std::string(100, 'a'));
+  m.assign(20, 30, std::string(100, 'b'));
+  m.assign(5, 40, m.at(15));
+  ASSERT_TRUE(m.size() == 1);
+  EXPECT_TRUE(m.begin().from() == 5 && m.begin().to() == 40);
+  EXPECT_TRUE(m.begin().value() == std::string(100, 'a'));
+
+  m.assign(40, 50, std::string(100, 'c'));
+  m.assign(45, 50, m.at(10));
+  EXPECT_TRUE(m.size() == 3);
+  EXPECT_TRUE(m.at(47) == std::string(100, 'a'));
+}
+
+TEST(RangeMapTest, Lookup) {
+  Map m;
+  m.assign(10, 20, 1);
+  m.assign(20, 30, 2);
+  EXPECT_FALSE(m.contains(9));
+  EXPECT_TRUE(m.at(10) == 1);
+  EXPECT_TRUE(m.at(19) == 1);
+  EXPECT_TRUE(m.at(20) == 2);
+  EXPECT_TRUE(m.at(29) == 2);
+  EXPECT_FALSE(m.contains(30));
+  EXPECT_THROW(m.at(30), std::out_of_range);
+  EXPECT_TRUE(m.find(25).from() == 20);
+  EXPECT_TRUE(m.find(5) == m.end());
+}
+
+TEST(RangeMapTest, Erase) {
+  Map m;
+  m.assign(10, 40, 1);
+  m.erase(20, 30);
+  EXPECT_TRUE(is(m, {{10, 20, 1}, {30, 40, 1}}));
+  m.assign(20, 30, 2);
+  m.erase(15, 35);
+  EXPECT_TRUE(is(m, {{10, 15, 1}, {35, 40, 1}}));
+  m.erase(0, 100);
+  EXPECT_TRUE(m.empty());
+}
+
+TEST(RangeMapTest, MatchesArray) {
+  constexpr std::size_t Size = 200;
+  Map m;
+  std::vector<int> model(Size, 0); // 0 means unassigned
+  std::mt19937 rng(777);
+  std::uniform_int_distribution<std::size_t> dist(0, Size);
+  std::uniform_int_distribution<int> vdist(0, 3);
+  for (int i = 0; i < 3000; ++i) {
+    std::size_t a = dist(rng);
+    std::size_t b = dist(rng);
+    int v = vdist(rng);
+    if (v == 0) {
+      m.erase(a, b);
+    } else {
+      m.assign(a, b, v);
+    }
+    for (std::size_t j = a; j < b; ++j)
+      model[j] = v;
+
+    // Compare against the maximal runs of the model.
+    std::vector<Entry> expected;
+    for (std::size_t j = 0; j < Size;) {
+      std::size_t k = j;
+      while (k < Size && model[k] == model[j])
+        ++k;
+      if (model[j] != 0)
+        expected.push_back({j, k, model[j]});
+      j = k;
+    }
+    ASSERT_TRUE(is(m, expected));
+  }
+}
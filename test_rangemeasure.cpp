@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangemeasureset.h"
+#include "rangeset.h"
+
+using Measure = HyoutaUtilities::RangeMeasureSet<uint32_t>;
+
+static bool same(const Measure& ms, const HyoutaUtilities::RangeSet<uint32_t>& rs) {
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  ms.for_each([&](uint32_t from, uint32_t to) { ranges.emplace_back(from, to); });
+  if (ranges.size() != rs.size() || ms.size() != rs.size())
+    return false;
+  std::size_t i = 0;
+  auto mit = ms.begin();
+  for (auto it = rs.begin(); it != rs.end(); ++it, ++mit, ++i) {
+    if (ranges[i].first != it.from() || ranges[i].second != it.to())
+      return false;
+    if (mit == ms.end() || mit.from() != it.from() || mit.to() != it.to())
+      return false;
+  }
+  if (mit != ms.end())
+    return false;
+
+  // And the same backwards.
+  for (auto it = rs.end(); it != rs.begin();) {
+    --it;
+    --mit;
+    if (mit.from() != it.from() || mit.to() != it.to())
+      return false;
+  }
+  return mit == ms.begin();
+}
+
+TEST(RangeMeasureTest, WindowQueries) {
+  Measure ms;
+  ms.insert(10, 20);
+  ms.insert(30, 35);
+  ms.insert(40, 100);
+
+  EXPECT_TRUE(ms.covered_size() == 75);
+  EXPECT_TRUE(ms.covered_size(0, 10) == 0);
+  EXPECT_TRUE(ms.covered_size(15, 32) == 7);
+  EXPECT_TRUE(ms.covered_size(0, 1000) == 75);
+
+  EXPECT_TRUE(ms.count_ranges(0, 10) == 0);
+  EXPECT_TRUE(ms.count_ranges(19, 20) == 1);
+  EXPECT_TRUE(ms.count_ranges(20, 30) == 0);
+  EXPECT_TRUE(ms.count_ranges(15, 41) == 3);
+
+  EXPECT_TRUE(ms.largest_in(0, 1000) == 60);
+  EXPECT_TRUE(ms.largest_in(0, 45) == 10);
+  EXPECT_TRUE(ms.largest_in(12, 36) == 8);
+  EXPECT_TRUE(ms.largest_in(31, 33) == 2);
+  EXPECT_TRUE(ms.largest_in(20, 30) == 0);
+
+  ms.erase(50, 60);
+  EXPECT_TRUE(ms.size() == 4);
+  EXPECT_TRUE(ms.largest_in(0, 1000) == 40);
+  EXPECT_TRUE(ms.find(55) == ms.end());
+  EXPECT_TRUE(ms.find(60).from() == 60 && ms.find(60).to() == 100);
+
+  ms.insert(20, 40);
+  EXPECT_TRUE(ms.size() == 2);
+  EXPECT_TRUE(ms.find(10).from() == 10 && ms.find(10).to() == 50);
+  EXPECT_TRUE(ms.find(10) == ms.begin());
+  EXPECT_TRUE(++ms.find(49) == --ms.end());
+  EXPECT_TRUE(ms.get_stats() == std::make_pair(std::size_t(80), 0.5));
+}
+
+TEST(RangeMeasureTest, RandomizedAgainstRangeSet) {
+  std::mt19937 rng(37);
+  std::uniform_int_distribution<uint32_t> point(0, 2000);
+  std::uniform_int_distribution<uint32_t> length(1, 60);
+  Measure ms;
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  for (int round = 0; round < 4000; ++round) {
+    const uint32_t from = point(rng);
+    const uint32_t to = from + length(rng);
+    if (rng() % 3 == 0) {
+      ms.erase(from, to);
+      rs.erase(from, to);
+    } else {
+      ms.insert(from, to);
+      rs.insert(from, to);
+    }
+    ASSERT_TRUE(same(ms, rs));
+
+    uint32_t lo = point(rng);
+    uint32_t hi = point(rng);
+    if (lo > hi)
+      std::swap(lo, hi);
+    std::size_t covered = 0;
+    std::size_t count = 0;
+    std::size_t largest = 0;
+    for (auto it = rs.begin(); it != rs.end(); ++it) {
+      const uint32_t a = std::max(it.from(), lo);
+      const uint32_t b = std::min(it.to(), hi);
+      if (a < b) {
+        covered += b - a;
+        ++count;
+        largest = std::max<std::size_t>(largest, b - a);
+      }
+    }
+    EXPECT_TRUE(ms.covered_size(lo, hi) == covered);
+    EXPECT_TRUE(ms.count_ranges(lo, hi) == count);
+    EXPECT_TRUE(ms.largest_in(lo, hi) == largest);
+    EXPECT_TRUE(ms.contains(lo) == rs.contains(lo));
+  }
+
+  Measure copy = ms;
+  EXPECT_TRUE(copy == ms);
+  copy.erase(0, 1);
+  copy.insert(5000, 5001);
+  EXPECT_TRUE(copy != ms);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "rangeset.h"
+#include "smallrangeset.h"
+
+template <std::size_t K>
+static bool same(const HyoutaUtilities::SmallRangeSet<std::size_t, K>& srs,
+                 const HyoutaUtilities::RangeSet<std::size_t>& rs) {
+  if (srs.size() != rs.size())
+    return false;
+  auto it = rs.begin();
+  for (auto sit = srs.begin(); sit != srs.end(); ++sit, ++it) {
+    if (sit.from() != it.from() || sit.to() != it.to())
+      return false;
+  }
+  return true;
+}
+
+TEST(SmallTest, SwitchesRepresentation) {
+  HyoutaUtilities::SmallRangeSet<std::size_t, 4> rs;
+  rs.insert(10, 20);
+  rs.insert(30, 40);
+  rs.insert(50, 60);
+  rs.insert(70, 80);
+  EXPECT_FALSE(rs.is_tree());
+  rs.insert(90, 100);
+  EXPECT_TRUE(rs.is_tree());
+  ASSERT_TRUE(rs.size() == 5);
+  EXPECT_TRUE(rs.contains(95));
+
+  rs.erase(10, 20);
+  rs.erase(30, 40);
+  EXPECT_TRUE(rs.is_tree());
+  rs.erase(50, 60);
+  EXPECT_FALSE(rs.is_tree());
+  ASSERT_TRUE(rs.size() == 2);
+  EXPECT_TRUE(rs.begin().from() == 70);
+
+  // Splitting a range in a full inline set has to switch to the tree as well.
+  rs.insert(0, 5);
+  rs.insert(110, 120);
+  EXPECT_FALSE(rs.is_tree());
+  rs.erase(112, 114);
+  EXPECT_TRUE(rs.is_tree());
+  ASSERT_TRUE(rs.size() == 5);
+}
+
+TEST(SmallTest, EraseIterator) {
+  HyoutaUtilities::SmallRangeSet<std::size_t, 4> rs;
+  for (std::size_t i = 0; i < 5; ++i)
+    rs.insert(i * 10, i * 10 + 5);
+  ASSERT_TRUE(rs.is_tree());
+  auto it = rs.erase(rs.begin());
+  ASSERT_TRUE(it.from() == 10);
+  it = rs.erase(it);
+  ASSERT_TRUE(rs.is_tree());
+  ASSERT_TRUE(it.from() == 20);
+  it = rs.erase(it);
+  ASSERT_TRUE(!rs.is_tree());
+  ASSERT_TRUE(it.from() == 30);
+  it = rs.erase(it);
+  ASSERT_TRUE(it.from() == 40);
+  it = rs.erase(it);
+  ASSERT_TRUE(it == rs.end());
+  ASSERT_TRUE(rs.empty());
+}
+
+TEST(SmallTest, EqualityAndSwapAcrossRepresentations) {
+  HyoutaUtilities::SmallRangeSet<std::size_t, 4> inline_rs;
+  HyoutaUtilities::SmallRangeSet<std::size_t, 4> tree_rs;
+  for (std::size_t i = 0; i < 5; ++i)
+    tree_rs.insert(i * 10, i * 10 + 5);
+  tree_rs.erase(20, 35);
+  inline_rs.insert(0, 5);
+  inline_rs.insert(10, 15);
+  inline_rs.insert(40, 45);
+  ASSERT_TRUE(tree_rs.is_tree());
+  ASSERT_FALSE(inline_rs.is_tree());
+  EXPECT_TRUE(inline_rs == tree_rs);
+
+  inline_rs.insert(60, 65);
+  EXPECT_TRUE(inline_rs != tree_rs);
+  inline_rs.swap(tree_rs);
+  EXPECT_TRUE(inline_rs.is_tree());
+  EXPECT_FALSE(tree_rs.is_tree());
+  EXPECT_TRUE(tree_rs.contains(60));
+  EXPECT_FALSE(inline_rs.contains(60));
+}
+
+TEST(SmallTest, MatchesRangeSet) {
+  HyoutaUtilities::SmallRangeSet<std::size_t, 8> srs;
+  HyoutaUtilities::RangeSet<std::size_t> rs;
+  std::mt19937 rng(54321);
+  std::uniform_int_distribution<std::size_t> dist(0, 300);
+  for (int i = 0; i < 5000; ++i) {
+    std::size_t a = dist(rng);
+    std::size_t b = a + dist(rng) / 10;
+    if (i % 3 != 0) {
+      srs.insert(a, b);
+      rs.insert(a, b);
+    } else {
+      srs.erase(a, b);
+      rs.erase(a, b);
+    }
+    ASSERT_TRUE(same(srs, rs));
+  }
+}
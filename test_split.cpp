@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangemeasureset.h"
+#include "rangeset.h"
+
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+static Ranges ranges_of(const HyoutaUtilities::RangeSet<uint32_t>& rs) {
+  Ranges ranges;
+  for (auto it = rs.begin(); it != rs.end(); ++it)
+    ranges.emplace_back(it.from(), it.to());
+  return ranges;
+}
+
+static Ranges ranges_of(const HyoutaUtilities::RangeMeasureSet<uint32_t>& ms) {
+  Ranges ranges;
+  for (auto it = ms.begin(); it != ms.end(); ++it)
+    ranges.emplace_back(it.from(), it.to());
+  return ranges;
+}
+
+TEST(SplitTest, SplitAndJoinRangeSet) {
+  HyoutaUtilities::RangeSet<uint32_t> rs;
+  rs.insert(0, 10);
+  rs.insert(20, 30);
+  rs.insert(40, 50);
+
+  auto upper = rs.split_at(25);
+  EXPECT_TRUE(ranges_of(rs) == Ranges({{0, 10}, {20, 25}}));
+  EXPECT_TRUE(ranges_of(upper) == Ranges({{25, 30}, {40, 50}}));
+
+  rs.join(std::move(upper));
+  EXPECT_TRUE(ranges_of(rs) == Ranges({{0, 10}, {20, 30}, {40, 50}}));
+
+  auto lower = rs.split_at(20);
+  EXPECT_TRUE(ranges_of(lower) == Ranges({{20, 30}, {40, 50}}));
+  lower.swap(rs);
+  // Now 'rs' holds the upper part, join the lower part in front of it.
+  rs.join(std::move(lower));
+  EXPECT_TRUE(ranges_of(rs) == Ranges({{0, 10}, {20, 30}, {40, 50}}));
+
+  auto everything = rs.split_at(0);
+  EXPECT_TRUE(rs.empty());
+  EXPECT_TRUE(everything.size() == 3);
+  EXPECT_TRUE(everything.split_at(100).empty());
+}
+
+TEST(SplitTest, RandomizedSplitJoin) {
+  std::mt19937 rng(43);
+  std::uniform_int_distribution<uint32_t> point(0, 1000);
+  std::uniform_int_distribution<uint32_t> length(1, 30);
+  for (int round = 0; round < 200; ++round) {
+    HyoutaUtilities::RangeSet<uint32_t> rs;
+    HyoutaUtilities::RangeMeasureSet<uint32_t> ms;
+    for (int i = 0; i < 40; ++i) {
+      const uint32_t from = point(rng);
+      const uint32_t to = from + length(rng);
+      rs.insert(from, to);
+      ms.insert(from, to);
+    }
+    const Ranges before = ranges_of(rs);
+    const std::size_t covered = ms.covered_size();
+
+    const uint32_t key = point(rng);
+    auto rs_upper = rs.split_at(key);
+    auto ms_upper = ms.split_at(key);
+    ASSERT_TRUE(ranges_of(rs) == ranges_of(ms));
+    ASSERT_TRUE(ranges_of(rs_upper) == ranges_of(ms_upper));
+    ASSERT_TRUE(rs.empty() || (--rs.end()).to() <= key);
+    ASSERT_TRUE(rs_upper.empty() || key <= rs_upper.begin().from());
+    ASSERT_TRUE(ms.covered_size() + ms_upper.covered_size() == covered);
+
+    if (rng() % 2 == 0) {
+      rs.join(std::move(rs_upper));
+      ms.join(std::move(ms_upper));
+    } else {
+      rs_upper.join(std::move(rs));
+      rs.swap(rs_upper);
+      ms_upper.join(std::move(ms));
+      ms.swap(ms_upper);
+    }
+    ASSERT_TRUE(ranges_of(rs) == before);
+    ASSERT_TRUE(ranges_of(ms) == before);
+    ASSERT_TRUE(ms.size() == before.size());
+  }
+}
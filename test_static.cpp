@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "rangeset.h"
+#include "staticrangeset.h"
+
+template <std::size_t N>
+static bool same(const HyoutaUtilities::StaticRangeSet<std::size_t, N>& srs,
+                 const HyoutaUtilities::RangeSet<std::size_t>& rs) {
+  if (srs.size() != rs.size())
+    return false;
+  auto it = rs.begin();
+  for (auto sit = srs.begin(); sit != srs.end(); ++sit, ++it) {
+    if (sit.from() != it.from() || sit.to() != it.to())
+      return false;
+  }
+  return true;
+}
+
+TEST(StaticTest, InsertErase) {
+  HyoutaUtilities::StaticRangeSet<std::size_t, 8> rs;
+  EXPECT_TRUE(rs.insert(10, 20));
+  EXPECT_TRUE(rs.insert(30, 40));
+  EXPECT_TRUE(rs.insert(20, 25));
+  ASSERT_TRUE(rs.size() == 2);
+  EXPECT_TRUE(rs.begin().from() == 10);
+  EXPECT_TRUE(rs.begin().to() == 25);
+  EXPECT_TRUE(rs.insert(5, 35));
+  ASSERT_TRUE(rs.size() == 1);
+  EXPECT_TRUE(rs.begin().from() == 5);
+  EXPECT_TRUE(rs.begin().to() == 40);
+
+  EXPECT_TRUE(rs.erase(10, 20));
+  ASSERT_TRUE(rs.size() == 2);
+  EXPECT_TRUE(rs.contains(5));
+  EXPECT_TRUE(rs.contains(9));
+  EXPECT_FALSE(rs.contains(10));
+  EXPECT_FALSE(rs.contains(19));
+  EXPECT_TRUE(rs.contains(20));
+  EXPECT_TRUE(rs.contains(39));
+  EXPECT_FALSE(rs.contains(40));
+
+  EXPECT_TRUE(rs.erase(0, 100));
+  EXPECT_TRUE(rs.empty());
+}
+
+TEST(StaticTest, Overflow) {
+  HyoutaUtilities::StaticRangeSet<std::size_t, 2> rs;
+  EXPECT_TRUE(rs.insert(10, 20));
+  EXPECT_TRUE(rs.insert(30, 40));
+  EXPECT_TRUE(rs.full());
+
+  // Neither of these fit.
+  EXPECT_FALSE(rs.insert(50, 60));
+  EXPECT_FALSE(rs.erase(32, 35));
+  ASSERT_TRUE(rs.size() == 2);
+  EXPECT_TRUE(rs.contains(33));
+  EXPECT_FALSE(rs.contains(55));
+
+  // These don't need an extra slot.
+  EXPECT_TRUE(rs.insert(20, 30));
+  ASSERT_TRUE(rs.size() == 1);
+  EXPECT_TRUE(rs.erase(32, 35));
+  ASSERT_TRUE(rs.size() == 2);
+  EXPECT_TRUE(rs.insert(40, 50));
+  EXPECT_FALSE(rs.insert(60, 70));
+}
+
+TEST(StaticTest, MatchesRangeSet) {
+  HyoutaUtilities::StaticRangeSet<std::size_t, 64> srs;
+  HyoutaUtilities::RangeSet<std::size_t> rs;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<std::size_t> dist(0, 200);
+  for (int i = 0; i < 5000; ++i) {
+    std::size_t a = dist(rng);
+    std::size_t b = dist(rng);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(srs.insert(a, b));
+      rs.insert(a, b);
+    } else {
+      ASSERT_TRUE(srs.erase(a, b));
+      rs.erase(a, b);
+    }
+    ASSERT_TRUE(same(srs, rs));
+  }
+}
+
+static constexpr HyoutaUtilities::StaticRangeSet<uint32_t, 4> build() {
+  HyoutaUtilities::StaticRangeSet<uint32_t, 4> rs;
+  rs.insert(0x1000, 0x2000);
+  rs.insert(0x8000, 0x9000);
+  rs.insert(0x2000, 0x3000);
+  rs.erase(0x8800, 0x8900);
+  return rs;
+}
+
+TEST(StaticTest, Constexpr) {
+  constexpr auto rs = build();
+  static_assert(rs.size() == 3);
+  static_assert(rs.contains(0x1000));
+  static_assert(rs.contains(0x2fff));
+  static_assert(!rs.contains(0x3000));
+  static_assert(!rs.contains(0x8800));
+  static_assert(rs.contains(0x8900));
+  EXPECT_TRUE(rs.begin().to() == 0x3000);
+}
+
+// Built entirely at compile time, only the final two ranges end up in the binary.
+static constexpr HyoutaUtilities::StaticRangeSet<uint32_t, 16> TableBuilder{
+    {0x0000, 0x1000}, {0x4000, 0x5000}, {0x1000, 0x2000}, {0x5000, 0x6000}, {0x1800, 0x2000}};
+static constexpr auto Table = TableBuilder.with_capacity<TableBuilder.size()>();
+
+TEST(StaticTest, CompileTimeTable) {
+  static_assert(Table.capacity() == 2);
+  static_assert(Table.size() == 2);
+  static_assert(Table.find(0x1fff) == Table.begin());
+  static_assert(Table.find(0x1fff).to() == 0x2000);
+  static_assert(Table.find(0x2000) == Table.end());
+  static_assert(Table.find(0x4000).from() == 0x4000);
+  static_assert(Table.find(0x4000).to() == 0x6000);
+  EXPECT_TRUE(Table.contains(0x5fff));
+  EXPECT_FALSE(Table.contains(0x6000));
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "rangesizeset.h"
+
+using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+static Ranges snapshot(const HyoutaUtilities::RangeSizeSet<uint32_t>& rs) {
+  Ranges ranges;
+  for (auto it = rs.begin(); it != rs.end(); ++it)
+    ranges.emplace_back(it.from(), it.to());
+  return ranges;
+}
+
+static bool sizes_consistent(const HyoutaUtilities::RangeSizeSet<uint32_t>& rs) {
+  std::size_t count = 0;
+  uint32_t previous = UINT32_MAX;
+  for (auto it = rs.by_size_begin(); it != rs.by_size_end(); ++it, ++count) {
+    const uint32_t size = it.to() - it.from();
+    if (size > previous || it.to_range_iterator().from() != it.from())
+      return false;
+    previous = size;
+  }
+  return count == rs.size();
+}
+
+TEST(TransactionSizeTest, RollbackRestoresSet) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> rs;
+  rs.insert(0, 10);
+  rs.insert(20, 30);
+  const Ranges before = snapshot(rs);
+
+  rs.begin_transaction();
+  EXPECT_TRUE(rs.in_transaction());
+  rs.insert(5, 25);
+  rs.erase(2, 3);
+  rs.erase(rs.by_size_begin());
+  rs.insert(40, 50);
+  rs.rollback();
+  EXPECT_FALSE(rs.in_transaction());
+  EXPECT_TRUE(snapshot(rs) == before);
+  EXPECT_TRUE(sizes_consistent(rs));
+
+  rs.begin_transaction();
+  rs.clear();
+  EXPECT_TRUE(rs.empty());
+  rs.rollback();
+  EXPECT_TRUE(snapshot(rs) == before);
+  EXPECT_TRUE(sizes_consistent(rs));
+}
+
+TEST(TransactionSizeTest, CommitKeepsChanges) {
+  HyoutaUtilities::RangeSizeSet<uint32_t> rs;
+  rs.insert(0, 10);
+  rs.begin_transaction();
+  rs.insert(10, 20);
+  rs.commit();
+  EXPECT_FALSE(rs.in_transaction());
+  EXPECT_TRUE(snapshot(rs) == Ranges({{0, 20}}));
+
+  // Changes after a commit are no longer undoable by a later transaction.
+  rs.begin_transaction();
+  rs.erase(5, 6);
+  rs.rollback();
+  EXPECT_TRUE(snapshot(rs) == Ranges({{0, 20}}));
+}
+
+TEST(TransactionSizeTest, RandomizedRollback) {
+  std::mt19937 rng(40);
+  std::uniform_int_distribution<uint32_t> point(0, 1000);
+  std::uniform_int_distribution<uint32_t> length(1, 50);
+  HyoutaUtilities::RangeSizeSet<uint32_t> rs;
+  for (int round = 0; round < 300; ++round) {
+    const Ranges before = snapshot(rs);
+    rs.begin_transaction();
+    for (int i = 0; i < 10; ++i) {
+      const uint32_t from = point(rng);
+      const uint32_t to = from + length(rng);
+      if (rng() % 2 == 0)
+        rs.erase(from, to);
+      else
+        rs.insert(from, to);
+    }
+    if (rng() % 2 == 0) {
+      rs.rollback();
+      ASSERT_TRUE(snapshot(rs) == before);
+    } else {
+      rs.commit();
+    }
+    ASSERT_TRUE(sizes_consistent(rs));
+  }
+}